@@ -0,0 +1,458 @@
+/**
+ *  @file   Benchmark.cpp
+ *  @brief  Contains micro and macro benchmarks of the analytic calculation, of the jet reconstruction, and of the generation whose results are written in JSON format
+ *
+ *  This file is a part of a project HadronProcessesLO (https://github.com/Sergeyir/HadronProcessesLO).
+ *
+ *  @author Sergei Antsupov (antsupov0124@gmail.com)
+ **/
+#ifndef BENCHMARK_CPP
+#define BENCHMARK_CPP
+
+#include "Benchmark.hpp"
+
+int main(int argc, char **argv)
+{
+   // pdf backend of the analytic calculation; "dummy" needs no pdf set files
+   std::string pdfBackend = "dummy";
+   std::string pdfSet = "";
+   // GenerateData is only benchmarked if its input file is given since it needs pdf set files
+   std::string generateDataInputFileName = "";
+   long numberOfEvents = 1000;
+   unsigned int maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+   std::string outputFileName = "output/benchmark.json";
+
+   // reading optional parameters
+   for (int i = 1; i < argc; i++)
+   {
+      const std::string option = argv[i];
+      // options without values
+      if (option == "--quick")
+      {
+         quickBenchmarks = true;
+         continue;
+      }
+      if (i + 1 >= argc)
+      {
+         std::cout << "\033[1m\033[31mError:\033[0m no value was provided for option " <<
+                      option << "\nUsage: bin/Benchmark [--quick] [--threads N] "\
+                      "[--pdf-backend dummy|lhapdf|grid] [--pdfset name] "\
+                      "[--generate-data inputFileName.yaml] [--events N] "\
+                      "[--output fileName.json]" << std::endl;
+         return 1;
+      }
+      if (option == "--threads") maxThreads = std::max(std::stoul(argv[++i]), 1ul);
+      else if (option == "--pdf-backend") pdfBackend = argv[++i];
+      else if (option == "--pdfset") pdfSet = argv[++i];
+      else if (option == "--generate-data") generateDataInputFileName = argv[++i];
+      else if (option == "--events") numberOfEvents = std::stol(argv[++i]);
+      else if (option == "--output") outputFileName = argv[++i];
+      else
+      {
+         std::cout << "\033[1m\033[31mError:\033[0m unknown option " << option << std::endl;
+         return 1;
+      }
+   }
+
+   if (pdfBackend != "dummy" && pdfBackend != "lhapdf" && pdfBackend != "grid")
+   {
+      std::cout << "\033[1m\033[31mError:\033[0m unknown pdf backend " << pdfBackend <<
+                   "; expected dummy, lhapdf, or grid" << std::endl;
+      return 1;
+   }
+   if (pdfBackend != "dummy" && pdfSet.empty())
+   {
+      std::cout << "\033[1m\033[31mError:\033[0m pdf backend " << pdfBackend <<
+                   " needs a pdf set; set it with option --pdfset" << std::endl;
+      return 1;
+   }
+
+   // ROOT needs to be notified that its objects will be used from multiple threads
+   ROOT::EnableThreadSafety();
+   TH1::AddDirectory(false);
+
+   // fixed seed makes the uncertainties of the integration the same in every run
+   baseSeed = 1;
+   threadPDFs.assign(maxThreads, nullptr);
+   pdfSetOfThreadPDFs = pdfSet;
+   if (pdfBackend == "dummy") pdfGrid = new PDFGrid();
+   else if (pdfBackend == "grid")
+   {
+      threadPDFs[0] = LHAPDF::mkPDF(pdfSet);
+      pdfGrid = new PDFGrid(threadPDFs[0]);
+   }
+
+   std::cout << "[\033[1m\033[32mINFO\033[0m] Running micro benchmarks" << std::endl;
+   const std::vector<JSONObject> microBenchmarks = RunMicroBenchmarks(pdfBackend);
+
+   std::cout << "[\033[1m\033[32mINFO\033[0m] Running integration with up to " <<
+                maxThreads << " thread(s)" << std::endl;
+   const std::vector<JSONObject> integrationScaling = RunIntegrationScaling(maxThreads);
+
+   std::cout << "[\033[1m\033[32mINFO\033[0m] Running integration of the reference bin "\
+                "pT = " << referencePT << " GeV/c" << std::endl;
+   const std::vector<JSONObject> timeToPrecision = RunTimeToPrecision();
+
+   std::vector<JSONObject> generationScaling;
+   if (!generateDataInputFileName.empty())
+   {
+      if (!std::filesystem::exists(generateDataInputFileName))
+      {
+         std::cout << "\033[1m\033[31mError:\033[0m file " << generateDataInputFileName <<
+                      " was not found" << std::endl;
+         return 1;
+      }
+      // GenerateData is built to the same directory as this executable
+      const std::string generateData =
+         (std::filesystem::absolute(argv[0]).lexically_normal().parent_path()/"GenerateData").string();
+
+      std::cout << "[\033[1m\033[32mINFO\033[0m] Running " << generateData <<
+                   " with up to " << maxThreads << " thread(s)" << std::endl;
+      generationScaling = RunGenerationScaling(generateData, generateDataInputFileName,
+                                               numberOfEvents, maxThreads);
+      if (generationScaling.empty()) return 1;
+   }
+
+   for (LHAPDF::PDF *threadPDF : threadPDFs) delete threadPDF;
+   delete pdfGrid;
+
+   // information on the run so that results of different builds and machines can be told apart
+   JSONObject info;
+   const std::time_t now = std::time(nullptr);
+   char date[32];
+   std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+   info.Add("date", std::string(date));
+#ifdef __VERSION__
+   info.Add("compiler", std::string(__VERSION__));
+#endif
+   info.Add("hardware_threads", static_cast<double>(std::thread::hardware_concurrency()));
+   info.Add("max_threads", static_cast<double>(maxThreads));
+   info.Add("pdf_backend", pdfBackend);
+   info.Add("pdfset", pdfSet);
+   info.Add("quick", quickBenchmarks ? 1. : 0.);
+
+   JSONObject results;
+   results.Add("info", info);
+   results.Add("micro", microBenchmarks);
+   results.Add("integration_scaling", integrationScaling);
+   results.Add("time_to_precision", timeToPrecision);
+   results.Add("generation_scaling", generationScaling);
+
+   const std::filesystem::path outputPath(outputFileName);
+   if (outputPath.has_parent_path()) std::filesystem::create_directories(outputPath.parent_path());
+   std::ofstream outputFile(outputFileName);
+   outputFile << results.ToString() << std::endl;
+   outputFile.close();
+
+   std::cout << "[\033[1m\033[32mINFO\033[0m] Results were written to " << outputFileName <<
+                " (checksum of micro benchmarks " << microBenchmarkSink << ")" << std::endl;
+
+   return 0;
+}
+
+template<typename Function>
+JSONObject RunMicroBenchmark(const std::string& name, Function function,
+                             const int numberOfInputs, const int callsPerInput)
+{
+   const double minSeconds = quickBenchmarks ? 0.02 : 0.2;
+   constexpr int numberOfRepetitions = 5;
+
+   double bestNanoseconds = std::numeric_limits<double>::max();
+   long totalCalls = 0;
+   for (int i = 0; i < numberOfRepetitions; i++)
+   {
+      long calls = 0;
+      double sum = 0.;
+      const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      double seconds = 0.;
+      do
+      {
+         for (int k = 0; k < numberOfInputs; k++) sum += function(k);
+         calls += static_cast<long>(numberOfInputs)*callsPerInput;
+         seconds = GetSecondsSince(start);
+      }
+      while (seconds < minSeconds);
+
+      microBenchmarkSink += sum;
+      totalCalls += calls;
+      bestNanoseconds = std::min(bestNanoseconds, 1e9*seconds/static_cast<double>(calls));
+   }
+
+   std::cout << "   " << name << ": " << bestNanoseconds << " ns" << std::endl;
+
+   JSONObject result;
+   result.Add("name", name);
+   result.Add("calls", static_cast<double>(totalCalls));
+   result.Add("ns_per_call", bestNanoseconds);
+   return result;
+}
+
+std::vector<JSONObject> RunMicroBenchmarks(const std::string& pdfBackend)
+{
+   SetThreadPDF(0, pdfSetOfThreadPDFs);
+
+   // points are distributed as in the integration of pT bins of CalculateAnalytic
+   TRandom random(1);
+   std::vector<double> pT(numberOfMicroBenchmarkInputs), y1(numberOfMicroBenchmarkInputs),
+                       y2(numberOfMicroBenchmarkInputs), x(numberOfMicroBenchmarkInputs),
+                       Q2(numberOfMicroBenchmarkInputs), s(numberOfMicroBenchmarkInputs),
+                       t(numberOfMicroBenchmarkInputs), u(numberOfMicroBenchmarkInputs);
+   for (int k = 0; k < numberOfMicroBenchmarkInputs; k++)
+   {
+      pT[k] = random.Uniform(25., 125.);
+      y1[k] = random.Uniform(-benchmarkAbsYMax, benchmarkAbsYMax);
+      y2[k] = random.Uniform(-benchmarkAbsYMax, benchmarkAbsYMax);
+      x[k] = exp(random.Uniform(log(1e-5), 0.));
+      Q2[k] = pT[k]*pT[k];
+
+      // mandelstam variables of the parton COM frame
+      const double deltaY = y1[k] - y2[k];
+      s[k] = 2.*pT[k]*pT[k]*(1. + cosh(deltaY));
+      t[k] = -pT[k]*pT[k]*(1. + exp(-deltaY));
+      u[k] = -pT[k]*pT[k]*(1. + exp(deltaY));
+   }
+
+   std::vector<JSONObject> results;
+
+   results.push_back(RunMicroBenchmark("GetX1", [&](const int k)
+                     {return GetX1(pT[k], benchmarkSqrtSNN, y1[k], y2[k]);}));
+   results.push_back(RunMicroBenchmark("GetX2", [&](const int k)
+                     {return GetX2(pT[k], benchmarkSqrtSNN, y1[k], y2[k]);}));
+   results.push_back(RunMicroBenchmark("GetDSigmaDOmega", [&](const int k)
+                     {return GetDSigmaDOmega(k % numberOfProcessClasses, 0.15, s[k], t[k], u[k]);}));
+   results.push_back(RunMicroBenchmark("GetDSigmaDPTDY1DY2", [&](const int k)
+                     {return GetDSigmaDPTDY1DY2(pT[k], benchmarkSqrtSNN, y1[k], y2[k]);}));
+
+   // blocks are benchmarked per point so that they can be compared with the scalar version
+   std::vector<double> blockValues(integrationBlockSize);
+   results.push_back(RunMicroBenchmark("GetDSigmaDPTDY1DY2Block", [&](const int k)
+   {
+      const int first = k*integrationBlockSize;
+      GetDSigmaDPTDY1DY2Block(pT.data() + first, y1.data() + first, y2.data() + first,
+                              benchmarkSqrtSNN, blockValues.data(), integrationBlockSize);
+      return blockValues[0];
+   }, numberOfMicroBenchmarkInputs/integrationBlockSize, integrationBlockSize));
+
+   std::vector<double> xfx;
+   if (pdfBackend == "lhapdf")
+   {
+      results.push_back(RunMicroBenchmark("LHAPDF::PDF::xfxQ2", [&](const int k)
+      {
+         pdf->xfxQ2(x[k], Q2[k], xfx);
+         return xfx[6];
+      }));
+   }
+   else
+   {
+      results.push_back(RunMicroBenchmark("PDFGrid::xfxQ2", [&](const int k)
+      {
+         pdfGrid->xfxQ2(x[k], Q2[k], xfx);
+         return xfx[6];
+      }));
+   }
+
+   // toy events: soft particles uniform in rapidity and azimuth with 2 back-to-back sprays
+   // of hard particles so that the clustering sees a dijet event of a typical size
+   constexpr int numberOfEvents = 16;
+   std::vector<std::vector<fastjet::PseudoJet>> events(numberOfEvents);
+   auto addParticle = [](std::vector<fastjet::PseudoJet>& particles, const double pT,
+                         const double eta, const double phi)
+   {
+      particles.emplace_back(pT*cos(phi), pT*sin(phi), pT*sinh(eta), pT*cosh(eta));
+   };
+   for (std::vector<fastjet::PseudoJet>& particles : events)
+   {
+      for (int i = 0; i < 300; i++)
+      {
+         addParticle(particles, 0.1 + random.Exp(0.5),
+                     random.Uniform(-5., 5.), random.Uniform(0., 2.*M_PI));
+      }
+      const double jetEta = random.Uniform(-2., 2.);
+      const double jetPhi = random.Uniform(0., 2.*M_PI);
+      for (int i = 0; i < 15; i++)
+      {
+         addParticle(particles, random.Exp(3.), jetEta + random.Gaus(0., 0.1),
+                     jetPhi + random.Gaus(0., 0.1));
+         addParticle(particles, random.Exp(3.), -jetEta + random.Gaus(0., 0.1),
+                     jetPhi + M_PI + random.Gaus(0., 0.1));
+      }
+   }
+
+   GeneratorSettings settings;
+   settings.pTHatMin = 25.;
+   settings.jetDefinitions.emplace_back(fastjet::antikt_algorithm, 0.4);
+   settings.jetNames.push_back("");
+   GeneratorOutput output(settings);
+   results.push_back(RunMicroBenchmark("FillJets (anti-kt R = 0.4, 330 particles)",
+                     [&](const int k)
+   {
+      FillJets(events[k], settings.jetDefinitions, settings.pTHatMin, 1., output);
+      return 0.;
+   }, numberOfEvents));
+
+   pdf = nullptr;
+   return results;
+}
+
+std::vector<JSONObject> RunIntegrationScaling(const unsigned int maxThreads)
+{
+   // pT bins as in CalculateAnalytic; every bin is one task of the first pass
+   const TAxis pTAxis(100, 25., 125.);
+   const long stepsPerBin = quickBenchmarks ? 2000 : 20000;
+
+   std::vector<PTBinTask> tasks;
+   for (int i = 1; i <= pTAxis.GetNbins(); i++) tasks.push_back({i, stepsPerBin, 0});
+   const double totalSteps = static_cast<double>(stepsPerBin*pTAxis.GetNbins());
+
+   std::vector<JSONObject> results;
+   for (const std::string integrator : {"plain", "vegas", "qmc"})
+   {
+      integrationMethod = integrator;
+
+      double singleThreadRate = 0.;
+      for (const unsigned int threads : GetThreadCounts(maxThreads))
+      {
+         numberOfThreads = threads;
+         std::vector<PTBinResult> dSigmaDPT(pTAxis.GetNbins());
+
+         // progress of the calculation is not printed
+         std::cout.setstate(std::ios::failbit);
+         const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+         RunPTBinTasks(pdfSetOfThreadPDFs, &pTAxis, benchmarkSqrtSNN, benchmarkAbsYMax,
+                       tasks, dSigmaDPT);
+         const double seconds = GetSecondsSince(start);
+         std::cout.clear();
+
+         const double rate = totalSteps/seconds;
+         if (threads == 1) singleThreadRate = rate;
+
+         std::cout << "   " << integrator << ", " << threads << " thread(s): " <<
+                      rate << " points/s" << std::endl;
+
+         JSONObject result;
+         result.Add("integrator", integrator);
+         result.Add("threads", static_cast<double>(threads));
+         result.Add("points", totalSteps);
+         result.Add("seconds", seconds);
+         result.Add("points_per_second", rate);
+         result.Add("speedup", rate/singleThreadRate);
+         results.push_back(result);
+      }
+   }
+   numberOfThreads = 1;
+   return results;
+}
+
+std::vector<JSONObject> RunTimeToPrecision()
+{
+   SetThreadPDF(0, pdfSetOfThreadPDFs);
+
+   const long maxSteps = quickBenchmarks ? 100000 : 5000000;
+
+   std::vector<JSONObject> results;
+   for (const std::string integrator : {"plain", "vegas", "qmc"})
+   {
+      integrationMethod = integrator;
+      for (long nSteps = 1000; nSteps <= maxSteps; nSteps *= 4)
+      {
+         // every number of steps is an independent calculation with the seed of the first bin
+         rnd.SetSeed(GetBinSeed(baseSeed, 1));
+         numberOfIntegrationSteps = nSteps;
+
+         double err;
+         const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+         const double dSigmaDPT = GetDSigmaDPT(referencePT, benchmarkSqrtSNN,
+                                               benchmarkAbsYMax, err);
+         const double seconds = GetSecondsSince(start);
+         const double relativeError = (dSigmaDPT != 0.) ? err/fabs(dSigmaDPT) : 0.;
+
+         std::cout << "   " << integrator << ", " << nSteps << " steps: relative error " <<
+                      relativeError << " in " << seconds << " s" << std::endl;
+
+         JSONObject result;
+         result.Add("integrator", integrator);
+         result.Add("steps", static_cast<double>(nSteps));
+         result.Add("seconds", seconds);
+         result.Add("dsigmadpT", dSigmaDPT);
+         result.Add("relative_error", relativeError);
+         results.push_back(result);
+      }
+   }
+
+   pdf = nullptr;
+   return results;
+}
+
+std::vector<JSONObject> RunGenerationScaling(const std::string& generateData,
+                                             const std::string& inputFileName,
+                                             const long numberOfEvents,
+                                             const unsigned int maxThreads)
+{
+   // GenerateData writes to the output directory of the working directory so
+   // it is run in a temporary directory in order to not overwrite the results of the user
+   const std::filesystem::path directory =
+      std::filesystem::temp_directory_path()/"HardProcessesLO_benchmark";
+   std::filesystem::create_directories(directory);
+   const std::string inputPath = std::filesystem::absolute(inputFileName).string();
+
+   std::vector<JSONObject> results;
+   double singleThreadRate = 0.;
+   for (const unsigned int threads : GetThreadCounts(maxThreads))
+   {
+      double seconds[2];
+      for (int i = 0; i < 2; i++)
+      {
+         const std::string command = "cd \"" + directory.string() + "\" && \"" + generateData +
+                                     "\" \"" + inputPath + "\" " +
+                                     std::to_string((i + 1)*numberOfEvents) + " --threads " +
+                                     std::to_string(threads) + " --seed 1 > /dev/null 2>&1";
+         const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+         if (std::system(command.c_str()) != 0)
+         {
+            std::cout << "\033[1m\033[31mError:\033[0m " << generateData <<
+                         " failed; check that it was built and that it runs with " <<
+                         inputFileName << std::endl;
+            std::filesystem::remove_all(directory);
+            return {};
+         }
+         seconds[i] = GetSecondsSince(start);
+      }
+
+      // initialization takes the same time in both runs
+      const double rate = static_cast<double>(numberOfEvents)/
+                          std::max(seconds[1] - seconds[0], 1e-9);
+      if (threads == 1) singleThreadRate = rate;
+
+      std::cout << "   " << threads << " thread(s): " << rate << " events/s" << std::endl;
+
+      JSONObject result;
+      result.Add("threads", static_cast<double>(threads));
+      result.Add("events", static_cast<double>(numberOfEvents));
+      result.Add("seconds", seconds[0]);
+      result.Add("seconds_double_events", seconds[1]);
+      result.Add("events_per_second", rate);
+      result.Add("speedup", rate/singleThreadRate);
+      results.push_back(result);
+   }
+
+   std::filesystem::remove_all(directory);
+   return results;
+}
+
+std::vector<unsigned int> GetThreadCounts(const unsigned int maxThreads)
+{
+   std::vector<unsigned int> threadCounts;
+   for (unsigned int threads = 1; threads < maxThreads; threads *= 2)
+   {
+      threadCounts.push_back(threads);
+   }
+   threadCounts.push_back(maxThreads);
+   return threadCounts;
+}
+
+double GetSecondsSince(const std::chrono::steady_clock::time_point& start)
+{
+   return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+#endif /* BENCHMARK_CPP */
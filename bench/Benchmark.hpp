@@ -0,0 +1,208 @@
+/**
+ *  @file   Benchmark.hpp
+ *  @brief  Contains micro and macro benchmarks of the analytic calculation, of the jet reconstruction, and of the generation whose results are written in JSON format
+ *
+ *  This file is a part of a project HadronProcessesLO (https://github.com/Sergeyir/HadronProcessesLO).
+ *
+ *  @author Sergei Antsupov (antsupov0124@gmail.com)
+ **/
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+#include <iostream>
+#include <vector>
+#include <filesystem>
+#include <string>
+#include <chrono>
+#include <sstream>
+#include <iomanip>
+#include <cmath>
+#include <fstream>
+#include <algorithm>
+#include <utility>
+#include <cstdlib>
+#include <ctime>
+
+#include "fastjet/PseudoJet.hh"
+#include "fastjet/ClusterSequence.hh"
+
+#include "TAxis.h"
+
+// functions and global parameters of the analytic calculation are used directly
+#define CALCULATE_ANALYTIC_NO_MAIN
+#include "CalculateAnalytic.cpp"
+
+#include "EventAnalysis.hpp"
+
+/* @class JSONObject
+ * @brief JSON object with numbers, strings, and other objects (or arrays of objects) as values;
+ * values are written in the order in which they were added
+ */
+class JSONObject
+{
+   public:
+
+   /* @brief Adds a number
+    *
+    * @param[in] key name of a value
+    * @param[in] value number
+    */
+   void Add(const std::string& key, const double value)
+   {
+      // JSON has no representation of infinity and NaN (e.g. the error of a failed benchmark)
+      if (!std::isfinite(value))
+      {
+         values.emplace_back(key, "null");
+         return;
+      }
+      std::ostringstream text;
+      text.precision(6);
+      text << value;
+      values.emplace_back(key, text.str());
+   }
+   /* @brief Adds a string
+    *
+    * @param[in] key name of a value
+    * @param[in] value string
+    */
+   void Add(const std::string& key, const std::string& value)
+   {
+      values.emplace_back(key, GetQuotedString(value));
+   }
+   /* @brief Adds an object
+    *
+    * @param[in] key name of a value
+    * @param[in] value object
+    */
+   void Add(const std::string& key, const JSONObject& value)
+   {
+      values.emplace_back(key, value.ToString());
+   }
+   /* @brief Adds an array of objects
+    *
+    * @param[in] key name of a value
+    * @param[in] value objects
+    */
+   void Add(const std::string& key, const std::vector<JSONObject>& value)
+   {
+      std::string text = "[";
+      for (std::size_t i = 0; i < value.size(); i++)
+      {
+         if (i > 0) text += ", ";
+         text += value[i].ToString();
+      }
+      values.emplace_back(key, text + "]");
+   }
+   /// @brief Returns the object written in JSON format
+   std::string ToString() const
+   {
+      std::string text = "{";
+      for (std::size_t i = 0; i < values.size(); i++)
+      {
+         if (i > 0) text += ", ";
+         text += GetQuotedString(values[i].first) + ": " + values[i].second;
+      }
+      return text + "}";
+   }
+
+   private:
+
+   /* @brief Returns the string in quotes with quotes, backslashes, and control characters escaped
+    * (strings such as names of pdf sets come from the command line)
+    *
+    * @param[in] value string
+    * @param[out] string written in JSON format
+    */
+   static std::string GetQuotedString(const std::string& value)
+   {
+      std::ostringstream text;
+      text << "\"";
+      for (const char c : value)
+      {
+         if (c == '"') text << "\\\"";
+         else if (c == '\\') text << "\\\\";
+         else if (c == '\n') text << "\\n";
+         else if (c == '\t') text << "\\t";
+         else if (static_cast<unsigned char>(c) < 0x20)
+         {
+            text << "\\u" << std::hex << std::setw(4) << std::setfill('0') << 
+                    static_cast<int>(c) << std::dec;
+         }
+         else text << c;
+      }
+      text << "\"";
+      return text.str();
+   }
+
+   /// keys and values written in JSON format
+   std::vector<std::pair<std::string, std::string>> values;
+};
+
+/// if true benchmarks run for shorter times and with fewer integration steps and events
+bool quickBenchmarks = false;
+/// center of mass energy of all benchmarks [GeV]
+constexpr double benchmarkSqrtSNN = 7000.;
+/// maximum absolute rapidity of partons of all benchmarks
+constexpr double benchmarkAbsYMax = 4.7;
+/// pT of the reference d\sigma / dp_T bin whose uncertainty is measured against time [GeV/c]
+constexpr double referencePT = 50.;
+/// number of inputs of micro benchmarks; they are reused in a loop so they stay in the cache
+constexpr int numberOfMicroBenchmarkInputs = 4096;
+/// sum of the results of micro benchmarks; it is printed so that the compiler can not remove the calls
+double microBenchmarkSink = 0.;
+
+/* @brief Measures time of a function called for every input of the micro benchmarks; calls are repeated until the minimum time is reached and the best of several repetitions is taken since it is the least affected by other processes
+ *
+ * @param[in] name name of the benchmark
+ * @param[in] function callable object that takes the index of an input and returns a number that is added to microBenchmarkSink
+ * @param[in] numberOfInputs number of inputs over which the function is called in a loop
+ * @param[in] callsPerInput number of calls that are made by one call of the function (e.g. number of points of a block)
+ * @param[out] result with the name, the number of calls, and the time per call [ns]
+ */
+template<typename Function>
+JSONObject RunMicroBenchmark(const std::string& name, Function function,
+                             const int numberOfInputs = numberOfMicroBenchmarkInputs,
+                             const int callsPerInput = 1);
+/* @brief Runs micro benchmarks of the kinematics, the matrix elements, d\sigma / dp_T dy_1 dy_2, pdf lookups, and the jet reconstruction of one event
+ *
+ * @param[in] pdfBackend pdf backend of the analytic calculation ("dummy", "lhapdf", or "grid")
+ * @param[out] results of all micro benchmarks
+ */
+std::vector<JSONObject> RunMicroBenchmarks(const std::string& pdfBackend);
+/* @brief Measures number of integration steps per second of all integrators for the increasing number of threads; every thread calculates its own pT bins as in CalculateAnalytic
+ *
+ * @param[in] maxThreads largest number of threads
+ * @param[out] results for every integrator and number of threads
+ */
+std::vector<JSONObject> RunIntegrationScaling(const unsigned int maxThreads);
+/* @brief Measures relative uncertainty of d\sigma / dp_T in the reference bin against time for the increasing number of integration steps for all integrators
+ *
+ * @param[out] results for every integrator and number of integration steps
+ */
+std::vector<JSONObject> RunTimeToPrecision();
+/* @brief Measures number of events per second of GenerateData for the increasing number of threads; every number of threads is run with numberOfEvents and 2*numberOfEvents events and the rate is calculated from the difference of times so that initialization is not included
+ *
+ * @param[in] generateData path of GenerateData executable
+ * @param[in] inputFileName input file of GenerateData
+ * @param[in] numberOfEvents number of events of the shorter run
+ * @param[in] maxThreads largest number of threads
+ * @param[out] results for every number of threads (empty if GenerateData failed)
+ */
+std::vector<JSONObject> RunGenerationScaling(const std::string& generateData,
+                                             const std::string& inputFileName,
+                                             const long numberOfEvents,
+                                             const unsigned int maxThreads);
+/* @brief Returns numbers of threads 1, 2, 4, ... up to and including maxThreads
+ *
+ * @param[in] maxThreads largest number of threads
+ * @param[out] numbers of threads
+ */
+std::vector<unsigned int> GetThreadCounts(const unsigned int maxThreads);
+/* @brief Returns time [s] since the given point
+ *
+ * @param[in] start point in time
+ * @param[out] time [s]
+ */
+double GetSecondsSince(const std::chrono::steady_clock::time_point& start);
+
+#endif /* BENCHMARK_HPP */
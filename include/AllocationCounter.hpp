@@ -0,0 +1,52 @@
+/**
+ *  @file   AllocationCounter.hpp
+ *  @brief  Contains declarations of the counter of heap allocations that is used to check that event loops do not allocate memory
+ *
+ *  This file is a part of a project HadronProcessesLO (https://github.com/Sergeyir/HadronProcessesLO).
+ *
+ *  @author Sergei Antsupov (antsupov0124@gmail.com)
+ **/
+#ifndef ALLOCATION_COUNTER_HPP
+#define ALLOCATION_COUNTER_HPP
+
+#include <atomic>
+
+/// number of allocations made by the current thread in the code of event loops while counting was enabled
+extern thread_local long allocationCount;
+/// number of allocations made by the current thread in jet reconstruction (i.e. by FASTJET3)
+extern thread_local long jetAllocationCount;
+/// counter to which allocations of the current thread are added; nullptr if they are not counted
+extern thread_local long *allocationCounter;
+/// number of counted allocations in the code of event loops of all finished threads
+extern std::atomic<long> totalAllocationCount;
+/// number of counted allocations in jet reconstruction of all finished threads
+extern std::atomic<long> totalJetAllocationCount;
+
+/// @brief Starts counting allocations of the current thread made in the code of event loops
+inline void StartCountingAllocations()
+{
+   allocationCounter = &allocationCount;
+}
+
+/// @brief Starts counting allocations of the current thread made in jet reconstruction
+inline void StartCountingJetAllocations()
+{
+   allocationCounter = &jetAllocationCount;
+}
+
+/// @brief Stops counting allocations of the current thread
+inline void StopCountingAllocations()
+{
+   allocationCounter = nullptr;
+}
+
+/// @brief Adds allocations counted by the current thread to the total numbers; it is called when a thread finishes
+inline void AddThreadAllocationCount()
+{
+   totalAllocationCount += allocationCount;
+   totalJetAllocationCount += jetAllocationCount;
+   allocationCount = 0;
+   jetAllocationCount = 0;
+}
+
+#endif /* ALLOCATION_COUNTER_HPP */
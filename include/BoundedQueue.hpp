@@ -0,0 +1,273 @@
+/**
+ *  @file   BoundedQueue.hpp
+ *  @brief  Contains declaration and implementation of class BoundedQueue that is a bounded lock-free multi-producer multi-consumer queue
+ *
+ *  This file is a part of a project HadronProcessesLO (https://github.com/Sergeyir/HadronProcessesLO).
+ *
+ *  @author Sergei Antsupov (antsupov0124@gmail.com)
+ **/
+#ifndef BOUNDED_QUEUE_HPP
+#define BOUNDED_QUEUE_HPP
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+
+/* @class BoundedQueue
+ * @brief Lock-free queue of fixed capacity for any number of producer and consumer threads
+ * (D. Vyukov, "Bounded MPMC queue"); every cell holds a sequence number that tells whether it is
+ * ready to be written or read at the current position so that threads only synchronize with atomic
+ * operations on the positions and on the cells
+ *
+ * Push waits while the queue is full which slows down the producers to the pace of the consumers
+ * (backpressure); Pop waits while the queue is empty until it is closed. Waiting threads first
+ * yield for a few attempts and then sleep on a condition variable so that they do not occupy cores
+ * when the other side is much slower; the mutex is only taken when some thread sleeps.
+ */
+template<typename T>
+class BoundedQueue
+{
+   public:
+
+   /* @brief Constructor
+    *
+    * @param[in] capacity maximum number of elements; it is rounded up to a power of 2
+    */
+   BoundedQueue(const std::size_t capacity);
+   /* @brief Adds an element if the queue is not full
+    *
+    * @param[in] value element that is added
+    * @param[out] true if the element was added
+    */
+   bool TryPush(const T& value);
+   /* @brief Takes an element if the queue is not empty
+    *
+    * @param[in] value variable to which the element is written
+    * @param[out] true if the element was taken
+    */
+   bool TryPop(T& value);
+   /* @brief Adds an element waiting while the queue is full
+    *
+    * @param[in] value element that is added
+    */
+   void Push(const T& value);
+   /* @brief Takes an element waiting while the queue is empty
+    *
+    * @param[in] value variable to which the element is written
+    * @param[out] true if the element was taken; false if the queue is closed and empty
+    */
+   bool Pop(T& value);
+   /// @brief Tells consumers that no more elements will be added; it must be called after all pushes
+   void Close();
+
+   private:
+
+   /// @brief Wakes up consumers that sleep while the queue is empty; it is called after a push
+   void NotifyConsumers();
+   /// @brief Wakes up producers that sleep while the queue is full; it is called after a pop
+   void NotifyProducers();
+
+   /* @struct Cell
+    * @brief Element of the ring buffer
+    */
+   struct Cell
+   {
+      /// position at which the cell can be written (equal) or read (larger by 1)
+      std::atomic<std::size_t> sequence;
+      /// stored element
+      T value;
+   };
+
+   /// ring buffer
+   std::unique_ptr<Cell[]> cells;
+   /// capacity - 1 (capacity is a power of 2)
+   std::size_t mask;
+   /// position of the next push; positions are placed on their own cache lines to avoid false sharing
+   alignas(64) std::atomic<std::size_t> enqueuePosition{0};
+   /// position of the next pop
+   alignas(64) std::atomic<std::size_t> dequeuePosition{0};
+   /// true if no more elements will be added
+   alignas(64) std::atomic<bool> closed{false};
+   /// number of failed attempts after which a waiting thread sleeps instead of yielding
+   static constexpr int numberOfSpins = 64;
+   /// numbers of producers and consumers that sleep
+   alignas(64) std::atomic<int> numberOfSleepingProducers{0};
+   std::atomic<int> numberOfSleepingConsumers{0};
+   /// mutex and condition variables of sleeping threads
+   std::mutex sleepMutex;
+   std::condition_variable notFull, notEmpty;
+};
+
+template<typename T>
+BoundedQueue<T>::BoundedQueue(const std::size_t capacity)
+{
+   std::size_t size = 2;
+   while (size < capacity) size *= 2;
+   mask = size - 1;
+
+   cells.reset(new Cell[size]);
+   for (std::size_t i = 0; i < size; i++) cells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+template<typename T>
+bool BoundedQueue<T>::TryPush(const T& value)
+{
+   std::size_t position = enqueuePosition.load(std::memory_order_relaxed);
+   while (true)
+   {
+      Cell &cell = cells[position & mask];
+      const std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      const std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) -
+                                        static_cast<std::ptrdiff_t>(position);
+      if (difference == 0)
+      {
+         // the cell is free; it is taken if no other producer has taken it in the meantime
+         if (enqueuePosition.compare_exchange_weak(position, position + 1,
+                                                   std::memory_order_relaxed))
+         {
+            cell.value = value;
+            cell.sequence.store(position + 1, std::memory_order_release);
+            return true;
+         }
+      }
+      // the cell was not read yet since the previous lap so the queue is full
+      else if (difference < 0) return false;
+      // another producer has taken the cell
+      else position = enqueuePosition.load(std::memory_order_relaxed);
+   }
+}
+
+template<typename T>
+bool BoundedQueue<T>::TryPop(T& value)
+{
+   std::size_t position = dequeuePosition.load(std::memory_order_relaxed);
+   while (true)
+   {
+      Cell &cell = cells[position & mask];
+      const std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      const std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) -
+                                        static_cast<std::ptrdiff_t>(position + 1);
+      if (difference == 0)
+      {
+         // the cell is filled; it is taken if no other consumer has taken it in the meantime
+         if (dequeuePosition.compare_exchange_weak(position, position + 1,
+                                                   std::memory_order_relaxed))
+         {
+            value = cell.value;
+            // the cell can be written again on the next lap
+            cell.sequence.store(position + mask + 1, std::memory_order_release);
+            return true;
+         }
+      }
+      // the cell was not written yet so the queue is empty
+      else if (difference < 0) return false;
+      // another consumer has taken the cell
+      else position = dequeuePosition.load(std::memory_order_relaxed);
+   }
+}
+
+template<typename T>
+void BoundedQueue<T>::Push(const T& value)
+{
+   for (int i = 0; i < numberOfSpins; i++)
+   {
+      if (TryPush(value))
+      {
+         NotifyConsumers();
+         return;
+      }
+      std::this_thread::yield();
+   }
+
+   std::unique_lock<std::mutex> lock(sleepMutex);
+   numberOfSleepingProducers++;
+   // the fence pairs with the one in NotifyProducers: either the consumer sees this producer 
+   // sleeping or this producer sees the cell freed by the consumer
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+   while (!TryPush(value)) notFull.wait(lock);
+   numberOfSleepingProducers--;
+   lock.unlock();
+
+   NotifyConsumers();
+}
+
+template<typename T>
+bool BoundedQueue<T>::Pop(T& value)
+{
+   bool isTaken = false;
+   for (int i = 0; i < numberOfSpins && !isTaken; i++)
+   {
+      if (TryPop(value)) isTaken = true;
+      // all elements pushed before closing are visible after the flag is read
+      else if (closed.load(std::memory_order_acquire)) 
+      {
+         if (!TryPop(value)) return false;
+         isTaken = true;
+      }
+      else std::this_thread::yield();
+   }
+
+   if (!isTaken)
+   {
+      std::unique_lock<std::mutex> lock(sleepMutex);
+      numberOfSleepingConsumers++;
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      while (true)
+      {
+         if (TryPop(value)) 
+         {
+            isTaken = true;
+            break;
+         }
+         // the flag is set under the mutex so it can not be missed here
+         if (closed.load(std::memory_order_acquire)) 
+         {
+            isTaken = TryPop(value);
+            break;
+         }
+         notEmpty.wait(lock);
+      }
+      numberOfSleepingConsumers--;
+   }
+
+   if (isTaken) NotifyProducers();
+   return isTaken;
+}
+
+template<typename T>
+void BoundedQueue<T>::Close()
+{
+   {
+      std::lock_guard<std::mutex> lock(sleepMutex);
+      closed.store(true, std::memory_order_release);
+   }
+   notEmpty.notify_all();
+}
+
+template<typename T>
+void BoundedQueue<T>::NotifyConsumers()
+{
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+   if (numberOfSleepingConsumers.load(std::memory_order_relaxed) == 0) return;
+   // the sleeping thread holds the mutex until it waits so the notification is not lost
+   {
+      std::lock_guard<std::mutex> lock(sleepMutex);
+   }
+   notEmpty.notify_one();
+}
+
+template<typename T>
+void BoundedQueue<T>::NotifyProducers()
+{
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+   if (numberOfSleepingProducers.load(std::memory_order_relaxed) == 0) return;
+   {
+      std::lock_guard<std::mutex> lock(sleepMutex);
+   }
+   notFull.notify_one();
+}
+
+#endif /* BOUNDED_QUEUE_HPP */
@@ -14,37 +14,563 @@
 #include <filesystem>
 #include <cmath>
 #include <chrono>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+#include <array>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <iomanip>
 
 #include "LHAPDF/LHAPDF.h"
 
 #include "yaml-cpp/yaml.h"
 
+#include "TROOT.h"
 #include "TFile.h"
 #include "TH1D.h"
+#include "TH2D.h"
 #include "TRandom.h"
 
+#include "PDFGrid.hpp"
+#include "VegasGrid.hpp"
+#include "SobolSequence.hpp"
+#include "ParameterScan.hpp"
+#include "RandomSeed.hpp"
+
 /// LHDAPDF::PDF object; it is used to obtain \alpha_Q, Q1, and Q2 
-/// if initialized for the given pdf set
-LHAPDF::PDF *pdf;
-/// ROOT TRandom object; it is used to randomly select y1, y2, and p_T for MC integration
-TRandom rnd;
-/// number of integration steps for MC integration
-long numberOfIntegrationSteps;
+/// if initialized for the given pdf set; every thread holds its own instance
+thread_local LHAPDF::PDF *pdf;
+/// in memory table of the pdf set; if it is initialized it is used instead of pdf;
+/// it is only read during the integration so one instance is shared between all threads
+PDFGrid *pdfGrid = nullptr;
+/// ROOT TRandom object; it is used to randomly select y1, y2, and p_T for MC integration;
+/// every thread holds its own instance which is reseeded at the start of every pT bin
+thread_local TRandom rnd;
+/// number of integration steps for MC integration; it is set by every thread 
+/// for every batch of integration steps it calculates
+thread_local long numberOfIntegrationSteps;
+/// number of flavours for which LHAPDF returns parton densities in one call (ids from -6 to 6)
+constexpr int numberOfPDFFlavours = 13;
+/// number of quark flavours that take part in hard processes (ids from -5 to 5 where 0 is gluon)
+constexpr int numberOfActiveFlavours = 5;
+
+/* @enum ProcessClass
+ * @brief Classes of 2 -> 2 processes; pairs of incoming partons of the same class have the same
+ * d\sigma / d\Omega summed over all final states
+ */
+enum ProcessClass
+{
+   /// qq' -> qq' and qq\bar' -> qq\bar' (quarks of different flavours)
+   qqPrimeProcess,
+   /// qq -> qq (identical quarks)
+   qqProcess,
+   /// qq\bar -> q'q\bar', qq\bar -> qq\bar, and qq\bar -> gg
+   qqBarProcess,
+   /// qg -> qg and gq -> gq
+   qgProcess,
+   /// gg -> gg and gg -> qq\bar
+   ggProcess,
+   /// number of classes
+   numberOfProcessClasses
+};
+
+/* @brief Returns class of 2 -> 2 processes for the given incoming partons
+ *
+ * @param[in] id1 id of a 1st parton (0 for gluon)
+ * @param[in] id2 id of a 2nd parton (0 for gluon)
+ * @param[out] class of processes (see ProcessClass)
+ */
+constexpr int GetProcessClass(const int id1, const int id2)
+{
+   if (id1 == 0 && id2 == 0) return ggProcess;
+   if (id1 == 0 || id2 == 0) return qgProcess;
+   if (id1 == id2) return qqProcess;
+   if (id1 == -id2) return qqBarProcess;
+   return qqPrimeProcess;
+}
+
+/// number of partons that take part in hard processes (quarks, antiquarks, and gluon)
+constexpr int numberOfActivePartons = 2*numberOfActiveFlavours + 1;
+
+/* @brief Returns table of process classes for all pairs of incoming partons
+ *
+ * @param[out] table in which element [id1 + numberOfActiveFlavours][id2 + numberOfActiveFlavours] is a class of processes for partons id1 and id2
+ */
+constexpr std::array<std::array<int, numberOfActivePartons>, numberOfActivePartons> 
+MakeProcessClassTable()
+{
+   std::array<std::array<int, numberOfActivePartons>, numberOfActivePartons> table{};
+   for (int id1 = -numberOfActiveFlavours; id1 <= numberOfActiveFlavours; id1++)
+   {
+      for (int id2 = -numberOfActiveFlavours; id2 <= numberOfActiveFlavours; id2++)
+      {
+         table[id1 + numberOfActiveFlavours][id2 + numberOfActiveFlavours] = 
+            GetProcessClass(id1, id2);
+      }
+   }
+   return table;
+}
+
+/// classes of processes for all pairs of incoming partons; it is generated during compilation
+constexpr auto processClassTable = MakeProcessClassTable();
+
+/// number of phase space points that are generated and evaluated together
+constexpr int integrationBlockSize = 256;
+
+/* @struct PhaseSpaceBlock
+ * @brief Intermediate values of d\sigma / dp_T dy_1 dy_2 calculation for a block of phase space points;
+ * every quantity is stored in its own array (structure of arrays) so that loops over points are vectorized
+ */
+struct PhaseSpaceBlock
+{
+   /// momentum fraction of the 1st parton
+   alignas(64) double x1[integrationBlockSize];
+   /// momentum fraction of the 2nd parton
+   alignas(64) double x2[integrationBlockSize];
+   /// squared hard scale \mu_F^2 = p_T^2 [GeV^2]
+   alignas(64) double Q2[integrationBlockSize];
+   /// mandelstam variable \hat{s} [GeV^2]
+   alignas(64) double s[integrationBlockSize];
+   /// mandelstam variable \hat{t} [GeV^2]
+   alignas(64) double t[integrationBlockSize];
+   /// mandelstam variable \hat{u} [GeV^2]
+   alignas(64) double u[integrationBlockSize];
+   /// 1 for kinematically allowed points and 0 for forbidden ones
+   alignas(64) double mask[integrationBlockSize];
+   /// \alpha_S at hard scale
+   alignas(64) double alphaS[integrationBlockSize];
+   /// x*f(x1, \mu_F^2) of partons with ids from -numberOfActiveFlavours to numberOfActiveFlavours
+   alignas(64) double xfx1[numberOfActivePartons][integrationBlockSize];
+   /// x*f(x2, \mu_F^2) of partons with ids from -numberOfActiveFlavours to numberOfActiveFlavours
+   alignas(64) double xfx2[numberOfActivePartons][integrationBlockSize];
+   /// parton luminosities of every class of processes
+   alignas(64) double luminosity[numberOfProcessClasses][integrationBlockSize];
+};
+/// MC integration method: "plain" for uniformly distributed points, "vegas" for adaptive 
+/// importance sampling (see VegasGrid), or "qmc" for quasi-Monte Carlo (see SobolSequence)
+std::string integrationMethod = "plain";
+/// number of VEGAS iterations; the first one is only used for the adaptation of the grid
+int numberOfVegasIterations = 5;
+/// number of VEGAS grid bins in every dimension
+int numberOfVegasBins = 50;
+/// number of independently scrambled Sobol sequences for quasi-Monte Carlo integration
+int numberOfQMCReplicas = 8;
+/// number of threads between which pT bins are distributed
+unsigned int numberOfThreads = 1;
+/// seed from which the seed of every pT bin is derived; the result does not 
+/// depend on the number of threads for the fixed value of this seed
+unsigned int baseSeed;
+/// true if baseSeed was set with option --seed; otherwise the seed of the cache is used
+bool isSeedSet = false;
+/// pdf objects of threads; they are kept between passes over pT bins
+std::vector<LHAPDF::PDF *> threadPDFs;
+/// name of the pdf set of threadPDFs and pdfGrid; they are kept between 
+/// configurations of a scan with the same pdf set
+std::string pdfSetOfThreadPDFs;
+/// index of the next task that has not been taken by any thread yet
+std::atomic<int> nextPTBinTask;
+/// number of tasks that have already been calculated (used to print progress)
+std::atomic<int> numberOfProcessedPTBinTasks;
+/// mutex that guards creation of pdf objects and printing of progress
+std::mutex threadsMutex;
+
+/* @struct PTBinTask
+ * @brief Batch of integration steps for one pT bin
+ */
+struct PTBinTask
+{
+   /// index of a pT bin
+   int bin;
+   /// number of integration steps
+   long nSteps;
+   /// index of a batch for this bin (0 for the first pass); it is used to derive the seed
+   int batch;
+};
+
+/* @struct PTBinResult
+ * @brief d\sigma / dp_T in one pT bin accumulated from independent batches of integration steps
+ * as the sum of values of all integration points, the sum of their squares, and their number;
+ * batches are merged by adding the sums so the value and its uncertainty are always calculated
+ * from all points as if they were obtained in one batch
+ */
+struct PTBinResult
+{
+   /// sum of values of all integration points
+   double sum = 0.;
+   /// sum of squares of values of all integration points
+   double sum2 = 0.;
+   /// total number of integration steps
+   long nSteps = 0;
+
+   /* @brief Adds result of a batch; for plain MC the mean and its standard error are converted 
+    * back to the exact sums of the batch, while for VEGAS and QMC whose points are not equally 
+    * weighted the sums are the ones of the sample with the same mean and standard error
+    *
+    * @param[in] value d\sigma / dp_T obtained in a batch
+    * @param[in] err uncertainty of value
+    * @param[in] batchSteps number of integration steps in a batch
+    */
+   void Add(const double value, const double err, const long batchSteps)
+   {
+      const double n = static_cast<double>(batchSteps);
+      sum += n*value;
+      // err^2 = (sum2/n - value^2)/(n - 1)
+      sum2 += n*value*value + n*(n - 1.)*err*err;
+      nSteps += batchSteps;
+   }
+   /// @brief Returns d\sigma / dp_T
+   double GetValue() const 
+   {
+      return (nSteps > 0) ? sum/static_cast<double>(nSteps) : 0.;
+   }
+   /// @brief Returns uncertainty of d\sigma / dp_T (standard error of the mean)
+   double GetError() const
+   {
+      if (nSteps < 2) return 0.;
+      const double n = static_cast<double>(nSteps);
+      const double mean = sum/n;
+      return sqrt(std::max(sum2/n - mean*mean, 0.)/(n - 1.));
+   }
+   /// @brief Returns relative uncertainty of d\sigma / dp_T (0 if both value and uncertainty are 0)
+   double GetRelativeError() const
+   {
+      if (GetError() == 0.) return 0.;
+      return GetError()/fabs(GetValue());
+   }
+};
+
+/// time [s] after which results of pT bins are written to the checkpoint; 0 means no checkpoints
+double checkpointInterval = 0.;
+/// if true the calculation is continued from the checkpoint of a previous run
+bool resumeFromCheckpoint = false;
+/// file to which results of pT bins and the tasks that are left are written
+const std::string checkpointFileName = "output/analytic_checkpoint.txt";
+/// parameters of the calculation written as one string (see GetResultCacheFileName); they are 
+/// written to the checkpoint and the checkpoint is resumed only with the same parameters
+std::string checkpointConfiguration;
+/// time at which the last checkpoint was written
+std::chrono::steady_clock::time_point lastCheckpointTime;
+/// index of the current pass over pT bins (0 for the first pass)
+int currentPass = 0;
+/// number of integration steps given to all pT bins including the ones of the current pass
+long numberOfUsedSteps = 0;
+/// maximum number of passes after the first one in the target precision mode; it stops 
+/// the calculation if the target precision can not be reached and no budget is set
+int maxNumberOfPasses = 20;
+/// maximum number of integration steps in one batch of a pT bin; batches grow up to 8 times 
+/// every pass and the limit keeps the numbers of steps far from the overflow
+constexpr long maxBatchSteps = 1L << 40;
+/// flags of the tasks of the current pass that have been calculated
+std::vector<char> isPTBinTaskDone;
+/// if true results of pT bins of previous runs with the same configuration are read from 
+/// the cache and new integration steps are added to them; results are written to the cache at the end
+bool useResultCache = true;
+
+/* @enum Observable
+ * @brief Quantities of a phase space point that can be histogrammed in "events" mode
+ */
+enum Observable
+{
+   /// transverse momentum of partons [GeV/c]
+   pTObservable,
+   /// rapidity of the 1st parton
+   y1Observable,
+   /// rapidity of the 2nd parton
+   y2Observable,
+   /// rapidity difference y_1 - y_2
+   deltaYObservable,
+   /// rapidity of the parton pair (y_1 + y_2)/2
+   yBoostObservable,
+   /// momentum fraction of the 1st parton
+   x1Observable,
+   /// momentum fraction of the 2nd parton
+   x2Observable,
+   /// invariant mass of the parton pair \sqrt{\hat{s}} [GeV]
+   massObservable,
+   /// number of observables
+   numberOfObservables
+};
+
+/// names of observables in the input file in the order of Observable
+const std::array<std::string, numberOfObservables> observableNames =
+   {"pT", "y1", "y2", "deltaY", "yBoost", "x1", "x2", "mass"};
+/// "bins" to integrate d\sigma / dp_T in every pT bin separately or "events" to sample
+/// phase space points once and fill all histograms defined in the input file with them
+std::string analyticMode = "bins";
+/// power n of p_T^{-n} distribution from which pT is sampled in "events" mode;
+/// the smaller it is the more points are placed at large pT
+double pTSamplingPower = 2.;
+/// number of phase space points in one chunk of "events" mode; every chunk has its own seed
+constexpr long eventChunkSize = 1L << 16;
+/// index of the next chunk of phase space points that has not been taken by any thread yet
+std::atomic<long> nextEventChunk;
+/// index of the next chunk which histograms are to be added to the result
+long nextEventChunkToMerge;
+/// notifies threads waiting for their turn to add histograms of their chunks to the result
+std::condition_variable eventChunkMerged;
+
+/* @struct ObservableHistogram
+ * @brief Sums of weights in bins of 1 or 2 observables filled in "events" mode; ROOT histograms
+ * are only created at the end since they are not needed in threads and filling them is slower
+ */
+struct ObservableHistogram
+{
+   /// name of a histogram in the output file
+   std::string name;
+   /// title of a histogram in the output file
+   std::string title;
+   /// observable alongside X axis (see Observable)
+   int observableX;
+   /// number of bins alongside X axis
+   int nBinsX;
+   /// minimum of X axis
+   double minX;
+   /// maximum of X axis
+   double maxX;
+   /// observable alongside Y axis (-1 for 1D histograms)
+   int observableY = -1;
+   /// number of bins alongside Y axis (1 for 1D histograms)
+   int nBinsY = 1;
+   /// minimum of Y axis
+   double minY = 0.;
+   /// maximum of Y axis
+   double maxY = 1.;
+   /// sums of weights; bin (i, j) including underflow and overflow is placed at j*(nBinsX + 2) + i
+   std::vector<double> sumOfWeights;
+   /// sums of squared weights in the same layout as sumOfWeights
+   std::vector<double> sumOfWeights2;
 
-/* @brief Returns random number that can be used as seed for TRandom
+   /// @brief Sets sums of weights to 0 (also allocates them for the first call)
+   void Reset()
+   {
+      const std::size_t size = static_cast<std::size_t>((nBinsX + 2)*(nBinsY + 2));
+      sumOfWeights.assign(size, 0.);
+      sumOfWeights2.assign(size, 0.);
+   }
+   /* @brief Returns index of a bin including underflow (0) and overflow (nBins + 1) ones
+    *
+    * @param[in] value value of an observable
+    * @param[in] nBins number of bins
+    * @param[in] min minimum of an axis
+    * @param[in] max maximum of an axis
+    * @param[out] index of a bin
+    */
+   static int FindBin(const double value, const int nBins, const double min, const double max)
+   {
+      if (value < min) return 0;
+      if (value >= max) return nBins + 1;
+      return std::min(1 + static_cast<int>((value - min)/(max - min)*nBins), nBins);
+   }
+   /* @brief Adds weight to the bin of the given phase space point
+    *
+    * @param[in] observables values of all observables of a phase space point (see Observable)
+    * @param[in] weight weight of a phase space point
+    */
+   void Fill(const double *observables, const double weight)
+   {
+      int index = FindBin(observables[observableX], nBinsX, minX, maxX);
+      if (observableY >= 0)
+      {
+         index += (nBinsX + 2)*FindBin(observables[observableY], nBinsY, minY, maxY);
+      }
+      sumOfWeights[index] += weight;
+      sumOfWeights2[index] += weight*weight;
+   }
+   /* @brief Adds sums of weights of the histogram with the same binning
+    *
+    * @param[in] other histogram which sums are added
+    */
+   void Add(const ObservableHistogram& other)
+   {
+      for (std::size_t i = 0; i < sumOfWeights.size(); i++)
+      {
+         sumOfWeights[i] += other.sumOfWeights[i];
+         sumOfWeights2[i] += other.sumOfWeights2[i];
+      }
+   }
+   /// @brief Writes ROOT histogram with sums of weights divided by bin widths (areas for 2D histograms), i.e. with differential cross section, to the current directory
+   void Write() const
+   {
+      const double widthX = (maxX - minX)/static_cast<double>(nBinsX);
+      if (observableY < 0)
+      {
+         TH1D distr(name.c_str(), title.c_str(), nBinsX, minX, maxX);
+         for (int i = 1; i <= nBinsX; i++)
+         {
+            distr.SetBinContent(i, sumOfWeights[i]/widthX);
+            distr.SetBinError(i, sqrt(sumOfWeights2[i])/widthX);
+         }
+         distr.Write();
+         return;
+      }
+
+      const double area = widthX*(maxY - minY)/static_cast<double>(nBinsY);
+      TH2D distr(name.c_str(), title.c_str(), nBinsX, minX, maxX, nBinsY, minY, maxY);
+      for (int i = 1; i <= nBinsX; i++)
+      {
+         for (int j = 1; j <= nBinsY; j++)
+         {
+            distr.SetBinContent(i, j, sumOfWeights[j*(nBinsX + 2) + i]/area);
+            distr.SetBinError(i, j, sqrt(sumOfWeights2[j*(nBinsX + 2) + i])/area);
+         }
+      }
+      distr.Write();
+   }
+};
+
+/* @brief Reads parameters of one configuration and calculates d\sigma / dp_T in pT bins (or fills the histograms of "events" mode); histograms are written to the current directory
+ *
+ * @param[in] inputFileContents contents of the input file (or of a configuration of a scan)
+ * @param[in] numberOfPilotSteps number of integration steps of every pT bin in the first pass (or the total number of phase space points in "events" mode)
+ * @param[in] targetPrecision target relative uncertainty of every pT bin (0 if only the first pass is performed)
+ * @param[in] integrationStepsBudget maximum total number of integration steps (0 means no limit)
+ * @param[in] tasks tasks of the current pass restored from the checkpoint (empty if the run is not resumed)
+ * @param[in] dSigmaDPT results of pT bins restored from the checkpoint (empty if the run is not resumed)
+ * @param[out] true if the calculation was performed; otherwise the error is printed and false is returned
+ */
+bool CalculateConfiguration(const YAML::Node& inputFileContents, const long numberOfPilotSteps, 
+                            const double targetPrecision, const long integrationStepsBudget, 
+                            std::vector<PTBinTask>& tasks, std::vector<PTBinResult>& dSigmaDPT);
+/* @brief Calculates tasks (batches of integration steps in pT bins) with numberOfThreads threads
+ *
+ * @param[in] pdfSet name of a pdf set
+ * @param[in] pTAxis axis of a histogram in which bins d\sigma / dp_T is calculated
+ * @param[in] sqrtSNN square root of s_{NN} [GeV]
+ * @param[in] absYMax maximum absolute of a rapidity of a parton
+ * @param[in] tasks batches of integration steps; every bin must appear in them at most once
+ * @param[in] results d\sigma / dp_T for every bin (index 0 corresponds to bin 1) to which the results of tasks are added
+ */
+void RunPTBinTasks(const std::string& pdfSet, const TAxis *pTAxis, 
+                   const double sqrtSNN, const double absYMax, 
+                   const std::vector<PTBinTask>& tasks, std::vector<PTBinResult>& results);
+/* @brief Calculates tasks taken one by one from the shared counter nextPTBinTask; 
+ * this function is run by every thread and it uses a pdf object of this thread
+ *
+ * @param[in] threadIndex index of a thread (0 for the main thread)
+ * @param[in] pdfSet name of a pdf set
+ * @param[in] pTAxis axis of a histogram in which bins d\sigma / dp_T is calculated
+ * @param[in] sqrtSNN square root of s_{NN} [GeV]
+ * @param[in] absYMax maximum absolute of a rapidity of a parton
+ * @param[in] tasks batches of integration steps
+ * @param[in] results d\sigma / dp_T for every bin to which the results of tasks are added
+ */
+void ProcessPTBins(const unsigned int threadIndex, const std::string& pdfSet, 
+                   const TAxis *pTAxis, const double sqrtSNN, const double absYMax, 
+                   const std::vector<PTBinTask>& tasks, std::vector<PTBinResult>& results);
+/* @brief Writes checkpointConfiguration, seed, results of all pT bins, and the tasks of the current pass that have not been calculated yet to the checkpoint; the file is first written under a temporary name and then renamed so that a complete checkpoint always exists even if the program is stopped while it is written
+ *
+ * @param[in] tasks tasks of the current pass
+ * @param[in] results d\sigma / dp_T for every bin
+ */
+void WritePTBinCheckpoint(const std::vector<PTBinTask>& tasks, 
+                          const std::vector<PTBinResult>& results);
+/* @brief Reads checkpoint written with WritePTBinCheckpoint and restores checkpointConfiguration, the seed, currentPass, and numberOfUsedSteps
+ *
+ * @param[in] tasks vector to which the tasks of the current pass that are left are written
+ * @param[in] results vector to which the results of all pT bins are written
+ * @param[out] true if the checkpoint was read; otherwise the error is printed and false is returned
+ */
+bool ReadPTBinCheckpoint(std::vector<PTBinTask>& tasks, std::vector<PTBinResult>& results);
+/* @brief Returns name of the cache file of the results of pT bins for the given configuration; name contains 64-bit FNV-1a hash of the configuration
+ *
+ * @param[in] configuration parameters that define d\sigma / dp_T in pT bins written as one string
+ * @param[out] name of a file
+ */
+std::string GetResultCacheFileName(const std::string& configuration);
+/* @brief Writes configuration, seed, number of passes, and results of all pT bins to the cache; the file is first written under a temporary name and then renamed
+ *
+ * @param[in] fileName name of the cache file
+ * @param[in] configuration parameters that define d\sigma / dp_T in pT bins written as one string
+ * @param[in] results d\sigma / dp_T for every bin
+ */
+void WritePTBinCache(const std::string& fileName, const std::string& configuration,
+                     const std::vector<PTBinResult>& results);
+/* @brief Reads cache written with WritePTBinCache and restores the seed and currentPass so that new batches of integration steps get new seeds; the cache is not read if the seed set with option --seed differs from the one of the cache
+ *
+ * @param[in] fileName name of the cache file
+ * @param[in] configuration parameters that define d\sigma / dp_T in pT bins written as one string
+ * @param[in] results vector to which the results of all pT bins are written; its size must be equal to the number of bins
+ * @param[out] true if the cache was read; otherwise the error is printed and false is returned
+ */
+bool ReadPTBinCache(const std::string& fileName, const std::string& configuration,
+                    std::vector<PTBinResult>& results);
+/* @brief Sets pdf of the calling thread to its own LHAPDF::PDF object creating it if needed;
+ * nothing is done if pdfGrid is used since it is shared between all threads
+ *
+ * @param[in] threadIndex index of a thread (0 for the main thread)
+ * @param[in] pdfSet name of a pdf set
+ */
+void SetThreadPDF(const unsigned int threadIndex, const std::string& pdfSet);
+/* @brief Reads definitions of histograms for "events" mode from the input file; every entry has name, optional title, x, and optional y where x and y contain observable, bins, min, and max
+ *
+ * @param[in] node node of the input file with the list of histograms
+ * @param[in] histograms vector to which histograms are added
+ * @param[out] true if all definitions are correct; otherwise the error is printed and false is returned
  */
-unsigned int GetRandomSeed();
-/* @brief Calculates d\sigma / d\Omega for all processes id1+id2 -> X + X for the given pT, \sqrt{s'_{NN}}, and y
+bool ReadObservableHistograms(const YAML::Node& node, std::vector<ObservableHistogram>& histograms);
+/* @brief Samples nSteps phase space points with numberOfThreads threads and fills histograms with their weights; sums of weights in bins are integrals of d\sigma over the bins so the histograms need to be divided by bin widths to obtain differential cross sections
+ *
+ * @param[in] pdfSet name of a pdf set
+ * @param[in] sqrtSNN square root of s_{NN} [GeV]
+ * @param[in] absYMax maximum absolute of a rapidity of a parton
+ * @param[in] pTHatMin minimum pT of a hard process [GeV/c]
+ * @param[in] nSteps number of phase space points
+ * @param[in] histograms histograms that are filled
+ */
+void RunEventIntegration(const std::string& pdfSet, const double sqrtSNN, const double absYMax,
+                         const double pTHatMin, const long nSteps,
+                         std::vector<ObservableHistogram>& histograms);
+/* @brief Samples chunks of phase space points taken one by one from the shared counter nextEventChunk; this function is run by every thread and histograms of chunks are added to the result in the order of chunks so that the result does not depend on the number of threads
+ *
+ * @param[in] threadIndex index of a thread (0 for the main thread)
+ * @param[in] pdfSet name of a pdf set
+ * @param[in] sqrtSNN square root of s_{NN} [GeV]
+ * @param[in] absYMax maximum absolute of a rapidity of a parton
+ * @param[in] pTHatMin minimum pT of a hard process [GeV/c]
+ * @param[in] nSteps total number of phase space points
+ * @param[in] histograms histograms to which the sums of weights of chunks are added
+ */
+void ProcessEventChunks(const unsigned int threadIndex, const std::string& pdfSet,
+                        const double sqrtSNN, const double absYMax, const double pTHatMin,
+                        const long nSteps, std::vector<ObservableHistogram>& histograms);
+/* @brief Maps uniformly distributed number onto [min, max] with the distribution proportional to value^{-power}
+ *
+ * @param[in] u uniformly distributed number from [0, 1]
+ * @param[in] min lower limit (must be positive)
+ * @param[in] max upper limit
+ * @param[in] power power of the distribution
+ * @param[in] jacobian jacobian of the mapping, i.e. the weight by which the integrand must be multiplied
+ * @param[out] mapped value
+ */
+double SamplePowerLaw(const double u, const double min, const double max,
+                      const double power, double &jacobian);
+/* @brief Calculates all observables (see Observable) of a phase space point
  *
- * @param[in] id1 id of a 1st parton
- * @param[in] id2 id of a 2nd parton
  * @param[in] pT transverse momentum [GeV/c]
- * @param[in] s square root of s'_{NN} (' denotes parton COM frame) [GeV]
- * @param[in] y = y1 - y2
- * @param[out] d\sigma / dp_T dy_1 dy_2
+ * @param[in] sqrtSNN square root of s_{NN} [GeV]
+ * @param[in] y1 1st parton rapidity
+ * @param[in] y2 2nd parton rapidity
+ * @param[in] observables array of numberOfObservables values that will be filled
  */
-double GetDSigmaDOmega(const int id1, const int id2, const double pT, 
-                       const double s, const double y);
+void GetObservables(const double pT, const double sqrtSNN, const double y1, const double y2,
+                    double *observables);
+/* @brief Calculates d\sigma / d\Omega of the given class of processes summed over all final states for the given \sqrt{s'_{NN}}, t, and u
+ *
+ * @param[in] processClass class of processes (see ProcessClass)
+ * @param[in] alphaS \alpha_S at hard scale
+ * @param[in] s s'_{NN} (' denotes parton COM frame) [GeV^2]
+ * @param[in] t mandelstam variable t [GeV^2]
+ * @param[in] u mandelstam variable u [GeV^2]
+ * @param[out] d\sigma / d\Omega
+ */
+double GetDSigmaDOmega(const int processClass, const double alphaS, 
+                       const double s, const double t, const double u);
 /* @brief Calculates d\sigma / dp_T dy_1 dy_2 for the given pT, \sqrt{s'_{NN}}, y1, y2, x1, and x2
  *
  * @param[in] pT transverse momentum [GeV/c]
@@ -58,6 +584,20 @@ double GetDSigmaDOmega(const int id1, const int id2, const double pT,
 double GetDSigmaDPTDY1DY2(const double pT, const double s, 
                           const double y1, const double y2,
                           const double x1, const double x2);
+/* @brief Fills x*f(x, Q^2) for all flavours with one pdf call
+ *
+ * @param[in] x parton momentum fraction alongside Z axis
+ * @param[in] Q2 squared hard scale [GeV^2]
+ * @param[in] xfx vector of numberOfPDFFlavours values that will be filled; value for parton 
+ * with id is placed at index id + 6 (gluon is placed at index 6)
+ */
+void GetPartonDensities(const double x, const double Q2, std::vector<double>& xfx);
+/* @brief Returns \alpha_S(Q^2) from pdfGrid if it is initialized or from pdf otherwise
+ *
+ * @param[in] Q2 squared hard scale [GeV^2]
+ * @param[out] \alpha_S
+ */
+double GetAlphaS(const double Q2);
 /* @brief Calculates x (parton momentum fraction alongside Z axis) for the first parton for the given pT, \sqrt{s_{NN}}, y1, y2
  *
  * @param[in] pT transverse momentum [GeV/c]
@@ -76,6 +616,39 @@ double GetX1(const double pT, const double sqrtSNN, const double y1, const doubl
  * @param[out] x
  */
 double GetX2(const double pT, const double sqrtSNN, const double y1, const double y2);
+/* @brief Calculates d\sigma / dp_T dy_1 dy_2 for a block of phase space points; kinematics, pdfs, luminosities, and matrix elements are calculated for all points in separate loops that are vectorized by the compiler
+ *
+ * @param[in] pT array of transverse momenta [GeV/c]
+ * @param[in] y1 array of 1st parton rapidities
+ * @param[in] y2 array of 2nd parton rapidities
+ * @param[in] sqrtSNN square root of s_{NN} [GeV]
+ * @param[in] result array in which d\sigma / dp_T dy_1 dy_2 will be written (0 for kinematically forbidden points)
+ * @param[in] n number of points (not larger than integrationBlockSize)
+ * @param[out] number of kinematically allowed points
+ */
+int GetDSigmaDPTDY1DY2Block(const double *pT, const double *y1, const double *y2, 
+                            const double sqrtSNN, double *result, const int n);
+/* @brief Calculates d\sigma / dp_T dy_1 dy_2 for a block of points with the same pT
+ *
+ * @param[in] pT transverse momentum [GeV/c]
+ * @param[in] y rapidities of points: y1 of point k is placed at k and y2 at integrationBlockSize + k
+ * @param[in] sqrtSNN square root of s_{NN} [GeV]
+ * @param[in] values array in which d\sigma / dp_T dy_1 dy_2 will be written
+ * @param[in] n number of points (not larger than integrationBlockSize)
+ */
+void GetDSigmaDPTDY1DY2Block(const double pT, const double *y, const double sqrtSNN, 
+                             double *values, const int n);
+/* @brief Calculates d\sigma / dp_T dy_1 dy_2 for a block of points with the same \Delta y = y1 - y2
+ *
+ * @param[in] deltaY rapidity difference y_1 - y_2
+ * @param[in] points pT of point k is placed at k and y1 at integrationBlockSize + k
+ * @param[in] sqrtSNN square root of s_{NN} [GeV]
+ * @param[in] absYMax maximum absolute of a rapidity of a parton (points with larger |y2| give 0)
+ * @param[in] values array in which d\sigma / dp_T dy_1 dy_2 will be written
+ * @param[in] n number of points (not larger than integrationBlockSize)
+ */
+void GetDSigmaDDeltaYBlock(const double deltaY, const double *points, const double sqrtSNN, 
+                           const double absYMax, double *values, const int n);
 /* @brief Calculates d\sigma / dp_T for the given pT, \sqrt{s_{NN}} and rapidity range. Integration is be performed over [-absYMax, absYMax] range for both y1 and y2
  *
  * @param[in] pT transverse momentum [GeV/c]
@@ -90,9 +663,53 @@ double GetDSigmaDPT(const double pT, const double sqrtSNN, const double absYMax,
  * @param[in] deltaY rapidity difference y_1 - y_2
  * @param[in] sqrtSNN square root of s_{NN} [GeV]
  * @param[in] absYMax maximum absolute of a rapidity of a parton
+ * @param[in] pTHatMin minimum pT of a hard process [GeV/c]
  * @param[in] err statistic uncertainty tied to limited number of integration steps
- * @param[out] d\sigma / dp_T
+ * @param[out] d\sigma / d\Delta y
+ */
+double GetDSigmaDDeltaY(const double deltaY, const double sqrtSNN, const double absYMax, 
+                        const double pTHatMin, double &err);
+/* @brief Calculates the mean of the values of MC integration points and its statistical uncertainty from their sums
+ *
+ * @param[in] sum sum of the values of all points
+ * @param[in] sum2 sum of the squares of the values of all points
+ * @param[in] n number of points
+ * @param[in] err uncertainty of the mean
+ * @param[out] mean value
+ */
+double GetMeanAndError(const double sum, const double sum2, const long n, double &err);
+/* @brief Calculates d\sigma / dp_T dy_1 dy_2 for the given pT, \sqrt{s_{NN}}, y1, and y2; x1, x2, and \hat{s} are calculated from them
+ *
+ * @param[in] pT transverse momentum [GeV/c]
+ * @param[in] sqrtSNN square root of s_{NN} [GeV]
+ * @param[in] y1 1st parton rapidity
+ * @param[in] y2 2nd parton rapidity
+ * @param[out] d\sigma / dp_T dy_1 dy_2
+ */
+double GetDSigmaDPTDY1DY2(const double pT, const double sqrtSNN, const double y1, const double y2);
+/* @brief Integrates the function over the box with VEGAS adaptive importance sampling; numberOfIntegrationSteps are split equally between numberOfVegasIterations iterations and the results of all iterations except the first one are combined with weights inversely proportional to their variances
+ *
+ * @param[in] dimension number of integration variables
+ * @param[in] lower lower limits of integration variables
+ * @param[in] upper upper limits of integration variables
+ * @param[in] integrand callable object that takes block of points (const double *; coordinate d of point k is placed at d*integrationBlockSize + k), array in which integrand values will be written (double *), and number of points (int)
+ * @param[in] err statistic uncertainty tied to limited number of integration steps
+ * @param[out] integral
+ */
+template<typename Integrand>
+double IntegrateVegas(const int dimension, const double *lower, const double *upper, 
+                      Integrand integrand, double &err);
+/* @brief Integrates the function over the box with quasi-Monte Carlo: numberOfIntegrationSteps are split equally between numberOfQMCReplicas independently scrambled Sobol sequences and the uncertainty is obtained from the spread of their results
+ *
+ * @param[in] dimension number of integration variables
+ * @param[in] lower lower limits of integration variables
+ * @param[in] upper upper limits of integration variables
+ * @param[in] integrand callable object that takes block of points (const double *; coordinate d of point k is placed at d*integrationBlockSize + k), array in which integrand values will be written (double *), and number of points (int)
+ * @param[in] err statistic uncertainty tied to limited number of integration steps
+ * @param[out] integral
  */
-double GetDSigmaDPT(const double deltaY, const double sqrtSNN, const double absYMax, double &err);
+template<typename Integrand>
+double IntegrateQMC(const int dimension, const double *lower, const double *upper, 
+                    Integrand integrand, double &err);
 
 #endif /* CALCULATE_ANALYTIC_HPP */
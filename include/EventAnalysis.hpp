@@ -0,0 +1,237 @@
+/**
+ *  @file   EventAnalysis.hpp
+ *  @brief  Contains declarations of settings, histograms, and jet reconstruction that are shared by executables that analyze PYTHIA8 events
+ *
+ *  This file is a part of a project HadronProcessesLO (https://github.com/Sergeyir/HadronProcessesLO).
+ *
+ *  @author Sergei Antsupov (antsupov0124@gmail.com)
+ **/
+#ifndef EVENT_ANALYSIS_HPP
+#define EVENT_ANALYSIS_HPP
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <string>
+#include <sstream>
+
+#include "fastjet/PseudoJet.hh"
+#include "fastjet/ClusterSequence.hh"
+
+#include "yaml-cpp/yaml.h"
+
+#include "TH1D.h"
+#include "TTree.h"
+
+#include "GeneratorInfo.hpp"
+
+/* @struct GeneratorSettings
+ * @brief Parameters of the generation and the analysis read from the input file; they are
+ * read once in the main thread since YAML::Node objects are not safe to be read from several threads
+ */
+struct GeneratorSettings
+{
+   /// name of a pdf set from LHAPDF6
+   std::string pdfSet;
+   /// hard process lower bound on pT [GeV/c]
+   double pTHatMin;
+   /// collision energy [GeV] in a center of mass frame
+   double energyCM;
+   /// power n of the bias (pT-hat/pTHatBiasReference)^n with which events with large pT-hat are
+   /// generated more often; events get weights inverse to the bias (0 means no bias)
+   double pTHatBiasPower = 0.;
+   /// reference pT-hat of the bias [GeV/c]
+   double pTHatBiasReference;
+   /// if true only hard processes are generated (mode: "parton"): showers, multiparton 
+   /// interactions, and hadronization are switched off and jets are not reconstructed
+   bool partonLevel = false;
+   /// definitions of jets; all of them are reconstructed from the same final state particles
+   std::vector<fastjet::JetDefinition> jetDefinitions;
+   /// names of jet definitions that are appended to the names of their histograms
+   /// ("" for the only definition made from fastjet_r)
+   std::vector<std::string> jetNames;
+};
+
+/* @struct GeneratorOutput
+ * @brief Histograms and cross section information obtained by one Pythia8::Pythia object;
+ * outputs of all threads are merged into one at the end
+ */
+struct GeneratorOutput
+{
+   /// histogram in which pT of partons outgoing from hard processes will be written
+   TH1D distrHardProcessPartonsPT;
+   /// histograms in which reconstructed jets pT will be written; one for every jet definition
+   std::vector<TH1D> distrJetsPT;
+   /// cross section and numbers of events
+   GeneratorInfo info;
+
+   /* @brief Constructor; creates histograms
+    *
+    * @param[in] settings parameters of the generation and the analysis
+    */
+   GeneratorOutput(const GeneratorSettings& settings) :
+      // more info on TH1D you can find on https://root.cern.ch/doc/master/classTH1.html
+      // kinematically pT can go to much higher values but for this example statistical
+      // significant result can be obtained only for this range within reasonable processing time
+      distrHardProcessPartonsPT("Hard process outgoing parton pT", "N(p_{T})",
+                                1000 + static_cast<int>(settings.pTHatMin), 
+                                0., 100. + settings.pTHatMin)
+   {
+      // histograms are filled with event weights (they differ if pT-hat bias is used) so that
+      // their uncertainties are calculated from sums of squares of weights
+      distrHardProcessPartonsPT.Sumw2();
+      distrJetsPT.reserve(settings.jetNames.size());
+      for (const std::string& name : settings.jetNames)
+      {
+         distrJetsPT.emplace_back((name.empty() ? "Jet pT" : "Jet pT " + name).c_str(), 
+                                  "N(p_{T})", 1000 + static_cast<int>(settings.pTHatMin), 
+                                  0., 100. + settings.pTHatMin);
+         distrJetsPT.back().Sumw2();
+      }
+   }
+   /* @brief Adds histograms and combines cross sections of the output of another run
+    *
+    * @param[in] other output of an independent run with the same settings
+    */
+   void Add(const GeneratorOutput& other)
+   {
+      distrHardProcessPartonsPT.Add(&other.distrHardProcessPartonsPT);
+      for (unsigned int i = 0; i < distrJetsPT.size(); i++)
+      {
+         distrJetsPT[i].Add(&other.distrJetsPT[i]);
+      }
+      info.Add(other.info);
+   }
+   /// @brief Writes all histograms to the current directory
+   void Write() const
+   {
+      distrHardProcessPartonsPT.Write();
+      for (const TH1D& distr : distrJetsPT) distr.Write();
+   }
+   /* @brief Adds histograms written with GeneratorOutput::Write to the histograms of this output;
+    * histograms must not be attached to directories (see TH1::AddDirectory)
+    *
+    * @param[in] directory directory (or file) from which the histograms are read
+    * @param[out] true if all histograms were found and added
+    */
+   bool Read(TDirectory *directory)
+   {
+      bool isRead = true;
+      auto addStored = [&](TH1D& histogram)
+      {
+         TH1D *stored;
+         directory->GetObject(histogram.GetName(), stored);
+         if (!stored)
+         {
+            isRead = false;
+            return;
+         }
+         // TH1::Add fails if the stored histogram has different binning
+         if (!histogram.Add(stored)) isRead = false;
+         delete stored;
+      };
+
+      addStored(distrHardProcessPartonsPT);
+      for (TH1D& distr : distrJetsPT) addStored(distr);
+      return isRead;
+   }
+};
+
+/* @struct StoredEvent
+ * @brief Event as it is stored in a columnar event store (TTree with one branch per quantity);
+ * momenta are stored in single precision since it is sufficient for jet reconstruction
+ */
+struct StoredEvent
+{
+   /// weight of an event
+   double weight = 1.;
+   /// x components of momenta of final state particles [GeV/c]
+   std::vector<float> px;
+   /// y components of momenta of final state particles [GeV/c]
+   std::vector<float> py;
+   /// z components of momenta of final state particles [GeV/c]
+   std::vector<float> pz;
+   /// energies of final state particles [GeV]
+   std::vector<float> e;
+   /// x components of momenta of partons outgoing from the hard process [GeV/c]
+   std::vector<float> partonPx;
+   /// y components of momenta of partons outgoing from the hard process [GeV/c]
+   std::vector<float> partonPy;
+   /// z components of momenta of partons outgoing from the hard process [GeV/c]
+   std::vector<float> partonPz;
+   /// energies of partons outgoing from the hard process [GeV]
+   std::vector<float> partonE;
+   /// ids of partons outgoing from the hard process
+   std::vector<int> partonId;
+   /// pointers to the vectors above; TTree::SetBranchAddress needs their addresses to read vectors
+   std::vector<float> *pxAddress, *pyAddress, *pzAddress, *eAddress,
+                      *partonPxAddress, *partonPyAddress, *partonPzAddress, *partonEAddress;
+   /// pointer to partonId needed by TTree::SetBranchAddress
+   std::vector<int> *partonIdAddress;
+
+   /* @brief Creates branches for all quantities; the object must exist while the tree is filled
+    *
+    * @param[in] tree tree to which branches are added
+    */
+   void CreateBranches(TTree *tree);
+   /* @brief Sets addresses of all branches so that entries of the tree are read into this object
+    *
+    * @param[in] tree tree which branches are read
+    */
+   void SetBranchAddresses(TTree *tree);
+   /* @brief Adds a final state particle
+    *
+    * @param[in] particlePx x component of momentum [GeV/c]
+    * @param[in] particlePy y component of momentum [GeV/c]
+    * @param[in] particlePz z component of momentum [GeV/c]
+    * @param[in] particleE energy [GeV]
+    */
+   void AddParticle(const double particlePx, const double particlePy,
+                    const double particlePz, const double particleE)
+   {
+      px.push_back(static_cast<float>(particlePx));
+      py.push_back(static_cast<float>(particlePy));
+      pz.push_back(static_cast<float>(particlePz));
+      e.push_back(static_cast<float>(particleE));
+   }
+   /* @brief Adds a parton outgoing from the hard process
+    *
+    * @param[in] particlePx x component of momentum [GeV/c]
+    * @param[in] particlePy y component of momentum [GeV/c]
+    * @param[in] particlePz z component of momentum [GeV/c]
+    * @param[in] particleE energy [GeV]
+    * @param[in] id id of a parton
+    */
+   void AddParton(const double particlePx, const double particlePy,
+                  const double particlePz, const double particleE, const int id)
+   {
+      partonPx.push_back(static_cast<float>(particlePx));
+      partonPy.push_back(static_cast<float>(particlePy));
+      partonPz.push_back(static_cast<float>(particlePz));
+      partonE.push_back(static_cast<float>(particleE));
+      partonId.push_back(id);
+   }
+   /// @brief Removes all particles and partons
+   void Clear();
+};
+
+/* @brief Reads parameters from the input file
+ *
+ * @param[in] inputFileContents contents of the input file
+ * @param[in] settings parameters that are read
+ * @param[out] true if all parameters are correct
+ */
+bool ReadGeneratorSettings(const YAML::Node& inputFileContents, GeneratorSettings& settings);
+/* @brief Reconstructs jets of one event with all jet definitions and fills their histograms
+ *
+ * @param[in] particles final state particles of an event
+ * @param[in] jetDefinitions definitions of jets
+ * @param[in] pTMin minimum pT of jets [GeV/c]
+ * @param[in] eventWeight weight of an event
+ * @param[in] output histograms which are filled
+ */
+void FillJets(const std::vector<fastjet::PseudoJet>& particles,
+              const std::vector<fastjet::JetDefinition>& jetDefinitions, const double pTMin,
+              const double eventWeight, GeneratorOutput& output);
+
+#endif /* EVENT_ANALYSIS_HPP */
@@ -12,6 +12,17 @@
 #include <iostream>
 #include <vector>
 #include <filesystem>
+#include <string>
+#include <cmath>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <limits>
+#include <sstream>
 
 #include "LHAPDF/LHAPDF.h"
 
@@ -22,7 +33,196 @@
 
 #include "yaml-cpp/yaml.h"
 
+#include "TROOT.h"
 #include "TFile.h"
 #include "TH1D.h"
+#include "TTree.h"
+#include "TParameter.h"
+#include "Compression.h"
+#include "ROOT/TBufferMerger.hxx"
+
+#include "EventAnalysis.hpp"
+#include "BoundedQueue.hpp"
+#include "AllocationCounter.hpp"
+#include "ParameterScan.hpp"
+#include "RandomSeed.hpp"
+
+/// number of threads; every thread runs its own independently seeded Pythia8::Pythia object
+unsigned int numberOfThreads = 1;
+/// seed from which the seeds of all shards are derived
+unsigned int baseSeed;
+/// index of a shard, i.e. of an independent job of a production split between several jobs
+int shardIndex = 0;
+/// number of shards; if it is larger than 1 the output is written to a file of this shard
+int numberOfShards = 1;
+/// seed of this shard from which the seeds of all Pythia8::Pythia objects are derived
+unsigned int shardSeed;
+/// mutex that guards initialization of Pythia8::Pythia objects
+std::mutex threadsMutex;
+/// number of threads that reconstruct jets from events generated by other threads;
+/// if it is 0 every generating thread reconstructs jets of its own events
+unsigned int numberOfClusteringThreads = 0;
+/// number of events in a batch passed from generating to clustering threads
+constexpr int eventBatchSize = 64;
+/// if true final state particles, hard process partons, and weights of all events 
+/// are written to the event store from which jets can be reconstructed with bin/ReclusterData
+bool storeEvents = false;
+/// merges trees of events filled by all threads into one file of the event store
+ROOT::TBufferMerger *eventsMerger = nullptr;
+/// number of events after which the tree of a thread is passed to eventsMerger
+constexpr long eventStoreFlushSize = 10000;
+/// time [s] after which every generating thread writes its checkpoint; 0 means no checkpoints
+double checkpointInterval = 0.;
+/// if true the generation is continued from the checkpoints of a previous run
+bool resumeFromCheckpoint = false;
+
+/* @struct EventBatch
+ * @brief Compact final state particles of several events passed from a generating thread
+ * to a clustering thread; memory of vectors is kept when the batch is reused
+ */
+struct EventBatch
+{
+   /// weights of events
+   std::vector<double> weights;
+   /// index of the first particle of every event
+   std::vector<int> firstParticles;
+   /// px [GeV/c], py [GeV/c], pz [GeV/c], and e [GeV] of all particles one after another
+   std::vector<double> momenta;
+
+   /* @brief Starts a new event; particles added after this belong to it
+    *
+    * @param[in] weight weight of an event
+    */
+   void AddEvent(const double weight)
+   {
+      weights.push_back(weight);
+      firstParticles.push_back(static_cast<int>(momenta.size()/4));
+   }
+   /* @brief Adds a particle to the last event
+    *
+    * @param[in] px x component of momentum [GeV/c]
+    * @param[in] py y component of momentum [GeV/c]
+    * @param[in] pz z component of momentum [GeV/c]
+    * @param[in] e energy [GeV]
+    */
+   void AddParticle(const double px, const double py, const double pz, const double e)
+   {
+      momenta.push_back(px);
+      momenta.push_back(py);
+      momenta.push_back(pz);
+      momenta.push_back(e);
+   }
+   /// @brief Returns number of events
+   int GetNumberOfEvents() const
+   {
+      return static_cast<int>(weights.size());
+   }
+   /* @brief Returns index of the first particle of the event
+    *
+    * @param[in] event index of an event (the number of events gives the total number of particles)
+    * @param[out] index of a particle
+    */
+   int GetFirstParticle(const int event) const
+   {
+      if (event < GetNumberOfEvents()) return firstParticles[event];
+      return static_cast<int>(momenta.size()/4);
+   }
+   /// @brief Removes all events
+   void Clear()
+   {
+      weights.clear();
+      firstParticles.clear();
+      momenta.clear();
+   }
+};
+
+/// queue of batches filled by generating threads that wait for clustering threads
+BoundedQueue<EventBatch *> *filledBatches = nullptr;
+/// queue of empty batches returned by clustering threads
+BoundedQueue<EventBatch *> *freeBatches = nullptr;
+
+/* @brief Generates events of one configuration (or of a group of configurations that differ only in the analysis) with numberOfThreads generating threads and numberOfClusteringThreads clustering threads
+ *
+ * @param[in] settings parameters of the generation and the analysis
+ * @param[in] numberOfEvents number of events of this shard
+ * @param[in] outputs vector to which the outputs of all threads are written; outputs of all threads are added to the first one
+ */
+void GenerateConfiguration(const GeneratorSettings& settings, const long numberOfEvents, 
+                           std::vector<GeneratorOutput>& outputs);
+/* @brief Checks whether events of two configurations are generated with the same parameters so that they can share the generated events
+ *
+ * @param[in] settings1 parameters of the 1st configuration
+ * @param[in] settings2 parameters of the 2nd configuration
+ * @param[out] true if parameters of pythia of the configurations are the same
+ */
+bool HasSameGeneration(const GeneratorSettings& settings1, const GeneratorSettings& settings2);
+/* @brief Checks whether two jet definitions reconstruct the same jets so that the jets can be reconstructed once for both of them
+ *
+ * @param[in] jetDefinition1 1st jet definition
+ * @param[in] jetDefinition2 2nd jet definition
+ * @param[out] true if the algorithms, R parameters, and strategies of the definitions are the same
+ */
+bool IsSameJetDefinition(const fastjet::JetDefinition& jetDefinition1, 
+                         const fastjet::JetDefinition& jetDefinition2);
+/* @brief Sets all parameters of the generation for Pythia8::Pythia object
+ *
+ * @param[in] pythia object that is configured
+ * @param[in] settings parameters read from the input file
+ * @param[in] seed seed of the random number generator of pythia
+ */
+void ConfigurePythia(Pythia8::Pythia& pythia, const GeneratorSettings& settings, const int seed);
+/* @brief Generates events with its own Pythia8::Pythia object, reconstructs jets (or passes the events to clustering threads), and fills the histograms; this function is run by every generating thread
+ *
+ * @param[in] threadIndex index of a thread (0 for the main thread)
+ * @param[in] settings parameters read from the input file
+ * @param[in] nEvents number of events to generate
+ * @param[in] output histograms and cross section information of this thread
+ */
+void GenerateEvents(const unsigned int threadIndex, const GeneratorSettings& settings,
+                    const long nEvents, GeneratorOutput& output);
+/* @brief Returns name of the checkpoint file of a generating thread
+ *
+ * @param[in] threadIndex index of a thread (0 for the main thread)
+ * @param[out] name of a file
+ */
+std::string GetCheckpointFileName(const unsigned int threadIndex);
+/* @brief Returns string with the parameters of the input file on which histograms of a checkpoint depend; checkpoint can be resumed only by a run with the same string
+ *
+ * @param[in] settings parameters read from the input file
+ * @param[out] parameters of the generation and the analysis
+ */
+std::string GetCheckpointConfiguration(const GeneratorSettings& settings);
+/* @brief Writes configuration, histograms, cross section information, number of processed events, and state of the random number generator of a thread to its checkpoint file; the file is first written under a temporary name and then renamed so that a complete checkpoint always exists even if the program is stopped while it is written
+ *
+ * @param[in] threadIndex index of a thread (0 for the main thread)
+ * @param[in] settings parameters read from the input file
+ * @param[in] pythia Pythia8::Pythia object of a thread
+ * @param[in] output histograms of a thread
+ * @param[in] info cross section information of all events processed by a thread
+ * @param[in] nEventsDone number of processed events
+ * @param[in] nEvents number of events that a thread needs to generate
+ */
+void WriteCheckpoint(const unsigned int threadIndex, const GeneratorSettings& settings, 
+                     Pythia8::Pythia& pythia, const GeneratorOutput& output, 
+                     const GeneratorInfo& info, const long nEventsDone, const long nEvents);
+/* @brief Reads checkpoint of a thread written with WriteCheckpoint; histograms and cross section information are added to output and info only if the whole checkpoint was read
+ *
+ * @param[in] threadIndex index of a thread (0 for the main thread)
+ * @param[in] settings parameters read from the input file
+ * @param[in] pythia initialized Pythia8::Pythia object of a thread which random number generator state is restored
+ * @param[in] output histograms to which the histograms of the checkpoint are added
+ * @param[in] info cross section information of the events processed before the checkpoint
+ * @param[in] nEventsDone number of events processed before the checkpoint
+ * @param[out] true if the checkpoint was read
+ */
+bool ReadCheckpoint(const unsigned int threadIndex, const GeneratorSettings& settings,
+                    Pythia8::Pythia& pythia, GeneratorOutput& output, GeneratorInfo& info, 
+                    long& nEventsDone);
+/* @brief Reconstructs jets of batches of events taken from filledBatches until the queue is closed and empty; this function is run by every clustering thread
+ *
+ * @param[in] settings parameters read from the input file
+ * @param[in] output histograms of this thread
+ */
+void ClusterEvents(const GeneratorSettings& settings, GeneratorOutput& output);
 
 #endif /* GENERATE_DATA_HPP */
@@ -0,0 +1,100 @@
+/**
+ *  @file   GeneratorInfo.hpp
+ *  @brief  Contains declaration of struct GeneratorInfo that holds cross section information of a run of PYTHIA8 and combines it between independent runs
+ *
+ *  This file is a part of a project HadronProcessesLO (https://github.com/Sergeyir/HadronProcessesLO).
+ *
+ *  @author Sergei Antsupov (antsupov0124@gmail.com)
+ **/
+#ifndef GENERATOR_INFO_HPP
+#define GENERATOR_INFO_HPP
+
+#include <cmath>
+
+#include "TDirectory.h"
+#include "TParameter.h"
+
+/* @struct GeneratorInfo
+ * @brief Cross section and numbers of events of a run of PYTHIA8; histograms filled with event
+ * weights are normalized to the cross section by multiplying them by sigmaGen/weightSum
+ */
+struct GeneratorInfo
+{
+   /// estimated cross section of generated processes [mb]
+   double sigmaGen = 0.;
+   /// uncertainty of sigmaGen [mb]
+   double sigmaErr = 0.;
+   /// number of tried events; sigmaGen of independent runs are combined with these weights
+   long nTried = 0;
+   /// number of accepted events
+   long nAccepted = 0;
+   /// sum of weights of accepted events
+   double weightSum = 0.;
+
+   /* @brief Combines information of an independent run with the same settings
+    *
+    * @param[in] other information of another run
+    */
+   void Add(const GeneratorInfo& other)
+   {
+      // every sigmaGen is an independent estimate of the same cross section
+      // which precision is proportional to the number of tried events
+      const double totalTried = static_cast<double>(nTried + other.nTried);
+      if (totalTried > 0.)
+      {
+         const double weight = static_cast<double>(nTried);
+         const double otherWeight = static_cast<double>(other.nTried);
+         sigmaErr = sqrt(weight*weight*sigmaErr*sigmaErr +
+                         otherWeight*otherWeight*other.sigmaErr*other.sigmaErr)/totalTried;
+         sigmaGen = (weight*sigmaGen + otherWeight*other.sigmaGen)/totalTried;
+      }
+      nTried += other.nTried;
+      nAccepted += other.nAccepted;
+      weightSum += other.weightSum;
+   }
+   /// @brief Writes all values as TParameter objects to the current directory
+   void Write() const
+   {
+      TParameter<double>("sigmaGen", sigmaGen).Write();
+      TParameter<double>("sigmaErr", sigmaErr).Write();
+      TParameter<Long64_t>("nTried", nTried).Write();
+      TParameter<Long64_t>("nAccepted", nAccepted).Write();
+      TParameter<double>("weightSum", weightSum).Write();
+   }
+   /* @brief Reads all values written with GeneratorInfo::Write
+    *
+    * @param[in] directory directory (or file) from which the values are read
+    * @param[out] true if all values were found
+    */
+   bool Read(TDirectory *directory)
+   {
+      TParameter<double> *sigmaGenParameter, *sigmaErrParameter, *weightSumParameter;
+      TParameter<Long64_t> *nTriedParameter, *nAcceptedParameter;
+      directory->GetObject("sigmaGen", sigmaGenParameter);
+      directory->GetObject("sigmaErr", sigmaErrParameter);
+      directory->GetObject("nTried", nTriedParameter);
+      directory->GetObject("nAccepted", nAcceptedParameter);
+      directory->GetObject("weightSum", weightSumParameter);
+
+      const bool found = sigmaGenParameter && sigmaErrParameter && nTriedParameter &&
+                         nAcceptedParameter && weightSumParameter;
+      if (found)
+      {
+         sigmaGen = sigmaGenParameter->GetVal();
+         sigmaErr = sigmaErrParameter->GetVal();
+         nTried = nTriedParameter->GetVal();
+         nAccepted = nAcceptedParameter->GetVal();
+         weightSum = weightSumParameter->GetVal();
+      }
+
+      // objects read from a file are owned by the caller
+      delete sigmaGenParameter;
+      delete sigmaErrParameter;
+      delete nTriedParameter;
+      delete nAcceptedParameter;
+      delete weightSumParameter;
+      return found;
+   }
+};
+
+#endif /* GENERATOR_INFO_HPP */
@@ -0,0 +1,49 @@
+/**
+ *  @file   MergeData.hpp
+ *  @brief  Contains merging of the output files of several shards of GenerateData into one file
+ *
+ *  This file is a part of a project HadronProcessesLO (https://github.com/Sergeyir/HadronProcessesLO).
+ *
+ *  @author Sergei Antsupov (antsupov0124@gmail.com)
+ **/
+#ifndef MERGE_DATA_HPP
+#define MERGE_DATA_HPP
+
+#include <iostream>
+#include <vector>
+#include <filesystem>
+#include <string>
+#include <map>
+
+#include "TFile.h"
+#include "TDirectory.h"
+#include "TKey.h"
+#include "TList.h"
+#include "TH1.h"
+
+#include "GeneratorInfo.hpp"
+
+/// paths of merged histograms in the order in which they were first found
+std::vector<std::string> histogramPaths;
+/// merged histograms; the key is a path of a histogram in a file
+std::map<std::string, TH1 *> mergedHistograms;
+/// paths of directories that contain cross section information in the order in which they were first found
+std::vector<std::string> infoPaths;
+/// merged cross section information; the key is a path of a directory in a file ("" for the file itself)
+std::map<std::string, GeneratorInfo> mergedInfos;
+
+/* @brief Adds histograms and cross section information of the directory and all its subdirectories to the merged ones
+ *
+ * @param[in] directory directory (or file) that is merged
+ * @param[in] path path of the directory in a file ("" for the file itself)
+ */
+void MergeDirectory(TDirectory *directory, const std::string& path);
+/* @brief Returns directory of the output file with the given path creating it if needed
+ *
+ * @param[in] file output file
+ * @param[in] path path of a directory ("" for the file itself)
+ * @param[out] directory
+ */
+TDirectory *GetOutputDirectory(TFile& file, const std::string& path);
+
+#endif /* MERGE_DATA_HPP */
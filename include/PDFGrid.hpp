@@ -0,0 +1,146 @@
+/**
+ *  @file   PDFGrid.hpp
+ *  @brief  Contains declaration of class PDFGrid that tabulates LHAPDF pdf set in memory and interpolates it with batched lookups
+ *
+ *  This file is a part of a project HadronProcessesLO (https://github.com/Sergeyir/HadronProcessesLO).
+ *
+ *  @author Sergei Antsupov (antsupov0124@gmail.com)
+ **/
+#ifndef PDF_GRID_HPP
+#define PDF_GRID_HPP
+
+#include <vector>
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+
+#include "LHAPDF/LHAPDF.h"
+
+#include "TRandom.h"
+
+/* @class PDFGrid
+ * @brief Table of x*f(x, Q^2) for flavours from -6 to 6 and of \alpha_S(Q^2) that is filled once
+ * from LHAPDF::PDF object and then interpolated without virtual calls
+ *
+ * Table is uniform in u = ln(x/(1 - x)) and in ln(Q^2): u behaves as ln(x) at small x while
+ * also resolving the fall of the densities at x -> 1. Every flavour has its own contiguous
+ * array (structure of arrays) so that the batched lookup of one flavour only reads one array.
+ * Interpolation is bicubic (4-point Lagrange in every dimension) in (u, ln(Q^2)).
+ */
+class PDFGrid
+{
+   public:
+
+   /* @brief Constructor; fills the table from the given pdf
+    *
+    * @param[in] pdf LHAPDF::PDF object from which values are tabulated
+    * @param[in] Q2Min minimum Q^2 of the table if it is below the range of the pdf set 
+    * (values there are extrapolated by LHAPDF); the range of the pdf set is used otherwise
+    * @param[in] nU number of nodes alongside u = ln(x/(1 - x))
+    * @param[in] nLogQ2 number of nodes alongside ln(Q^2)
+    */
+   PDFGrid(const LHAPDF::PDF *pdf, const double Q2Min = 0., 
+           const int nU = 512, const int nLogQ2 = 128);
+   /* @brief Constructor; fills the table from a simple parametrization of the proton pdfs 
+    * and 1-loop \alpha_S (dummy pdf set) so that the code can be run and benchmarked without 
+    * pdf set files; its values are only roughly similar to the real ones
+    *
+    * @param[in] nU number of nodes alongside u = ln(x/(1 - x))
+    * @param[in] nLogQ2 number of nodes alongside ln(Q^2)
+    */
+   explicit PDFGrid(const int nU = 512, const int nLogQ2 = 128);
+   /* @brief Calculates x*f(x, Q^2) of one flavour for n points
+    *
+    * @param[in] flavour id of a parton (21 and 0 both correspond to gluon)
+    * @param[in] x array of parton momentum fractions
+    * @param[in] Q2 array of squared hard scales [GeV^2]
+    * @param[in] out array in which n values of x*f(x, Q^2) will be written
+    * @param[in] n number of points
+    */
+   void xfx(const int flavour, const double *x, const double *Q2,
+            double *out, const std::size_t n) const;
+   /* @brief Fills x*f(x, Q^2) of all flavours for one point; interpolation weights are calculated once and reused for every flavour
+    *
+    * @param[in] x parton momentum fraction
+    * @param[in] Q2 squared hard scale [GeV^2]
+    * @param[in] xfx vector of 13 values that will be filled; value for parton with id
+    * is placed at index id + 6 (gluon is placed at index 6) as in LHAPDF
+    */
+   void xfxQ2(const double x, const double Q2, std::vector<double>& xfx) const;
+   /* @brief Calculates \alpha_S(Q^2) for n points
+    *
+    * @param[in] Q2 array of squared hard scales [GeV^2]
+    * @param[in] out array in which n values of \alpha_S will be written
+    * @param[in] n number of points
+    */
+   void alphasQ2(const double *Q2, double *out, const std::size_t n) const;
+   /* @brief Returns \alpha_S(Q^2) for one point
+    *
+    * @param[in] Q2 squared hard scale [GeV^2]
+    * @param[out] \alpha_S
+    */
+   double alphasQ2(const double Q2) const;
+   /// @brief Returns minimum Q^2 of the table [GeV^2]; values below it are frozen at its edge
+   double GetQ2Min() const;
+   /* @brief Compares interpolated values with values from pdf in random points and returns the largest deviation;
+    * deviation is relative for values larger than 10^{-3} and absolute (scaled by 10^3) for smaller values
+    *
+    * @param[in] pdf LHAPDF::PDF object with which the comparison is performed
+    * @param[in] nPoints number of random points (x, Q^2) in which all flavours and \alpha_S are compared
+    * @param[in] Q2Min minimum Q^2 of compared points (below the pdf set range values are compared with the extrapolation of LHAPDF)
+    * @param[in] Q2Max maximum Q^2 of compared points (values above the pdf set range are ignored)
+    * @param[out] largest deviation
+    */
+   double GetMaxDeviation(const LHAPDF::PDF *pdf, const int nPoints,
+                          const double Q2Min, const double Q2Max) const;
+
+   private:
+
+   /* @brief Fills the table and the nodes from the given functions
+    *
+    * @param[in] xMin minimum x
+    * @param[in] xMax maximum x
+    * @param[in] Q2Min minimum Q^2 [GeV^2]
+    * @param[in] Q2Max maximum Q^2 [GeV^2]
+    * @param[in] getXFX callable object that fills vector of x*f(x, Q^2) of all flavours for x and Q^2 (as LHAPDF::PDF::xfxQ2)
+    * @param[in] getAlphaS callable object that returns \alpha_S(Q^2)
+    */
+   template<typename XFXFunction, typename AlphaSFunction>
+   void Fill(const double xMin, const double xMax, const double Q2Min, const double Q2Max,
+             XFXFunction getXFX, AlphaSFunction getAlphaS);
+   /* @brief Calculates index of the first of 4 nodes and cubic interpolation weights for the given position on the uniform grid
+    *
+    * @param[in] position position in units of node spacing relative to the first node
+    * @param[in] nNodes number of nodes
+    * @param[in] index index of the first of 4 nodes (output)
+    * @param[in] weights array of 4 weights (output)
+    */
+   static void GetStencil(const double position, const int nNodes, int &index, double *weights);
+   /* @brief Returns index of a flavour in the table for the given id
+    *
+    * @param[in] id id of a parton
+    * @param[out] index of a flavour
+    */
+   static int GetFlavourIndex(const int id);
+
+   /// number of flavours in the table (ids from -6 to 6)
+   static constexpr int nFlavours = 13;
+   /// number of nodes alongside u = ln(x/(1 - x))
+   int nU;
+   /// number of nodes alongside ln(Q^2)
+   int nLogQ2;
+   /// first node of u
+   double uMin;
+   /// inverse spacing between nodes alongside u
+   double uInvStep;
+   /// first node of ln(Q^2)
+   double logQ2Min;
+   /// inverse spacing between nodes alongside ln(Q^2)
+   double logQ2InvStep;
+   /// x*f(x, Q^2); value for flavour index f, Q^2 node j, and u node i is placed at (f*nLogQ2 + j)*nU + i
+   std::vector<double> table;
+   /// \alpha_S at ln(Q^2) nodes
+   std::vector<double> alphaSTable;
+};
+
+#endif /* PDF_GRID_HPP */
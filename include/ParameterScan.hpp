@@ -0,0 +1,43 @@
+/**
+ *  @file   ParameterScan.hpp
+ *  @brief  Contains declarations of struct ScanConfiguration and of the reading of the grid of configurations from the "scan" node of the input file
+ *
+ *  This file is a part of a project HadronProcessesLO (https://github.com/Sergeyir/HadronProcessesLO).
+ *
+ *  @author Sergei Antsupov (antsupov0124@gmail.com)
+ **/
+#ifndef PARAMETER_SCAN_HPP
+#define PARAMETER_SCAN_HPP
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cctype>
+
+#include "yaml-cpp/yaml.h"
+
+/* @struct ScanConfiguration
+ * @brief One point of the grid of parameters listed in the "scan" node of the input file
+ */
+struct ScanConfiguration
+{
+   /// contents of the input file in which the scanned parameters are replaced by the values
+   /// of this configuration; it can be read exactly as the input file itself
+   YAML::Node inputFileContents;
+   /// name of the directory of the output file to which the results of this configuration
+   /// are written, e.g. energy_7000_pdfset_CT14lo ("" if there is no "scan" node)
+   std::string name;
+   /// scanned parameters and their values, e.g. "energy=7000 pdfset=CT14lo"
+   std::string description;
+};
+
+/* @brief Reads the grid of configurations from the "scan" node of the input file; every key of the node is a parameter of the input file and its value is a list of values of this parameter; configurations are all combinations of these values in which the first parameter changes slowest; without the "scan" node the only configuration is the input file itself
+ *
+ * @param[in] inputFileContents contents of the input file
+ * @param[in] configurations vector to which configurations are added
+ * @param[out] true if the "scan" node is correct; otherwise the error is printed and false is returned
+ */
+bool ReadScanConfigurations(const YAML::Node& inputFileContents,
+                            std::vector<ScanConfiguration>& configurations);
+
+#endif /* PARAMETER_SCAN_HPP */
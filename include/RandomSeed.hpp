@@ -0,0 +1,42 @@
+/**
+ *  @file   RandomSeed.hpp
+ *  @brief  Contains declarations of functions that provide seeds of random number generators for all executables
+ *
+ *  This file is a part of a project HadronProcessesLO (https://github.com/Sergeyir/HadronProcessesLO).
+ *
+ *  @author Sergei Antsupov (antsupov0124@gmail.com)
+ **/
+#ifndef RANDOM_SEED_HPP
+#define RANDOM_SEED_HPP
+
+#include <chrono>
+#include <cstdint>
+
+/* @brief Returns random number that can be used as seed for TRandom and Pythia8::Pythia
+ */
+unsigned int GetRandomSeed();
+/* @brief Returns splitmix64 finalizer of the given value; close values are mapped to uncorrelated ones
+ *
+ * @param[in] value value that is hashed
+ * @param[out] hash
+ */
+uint64_t GetSplitMix64Hash(uint64_t value);
+/* @brief Returns seed for TRandom for the given pT bin and batch derived from baseSeed; 
+ * seeds for the neighbouring bins and batches are decorrelated by splitmix64 hash
+ *
+ * @param[in] seed base seed
+ * @param[in] bin index of a pT bin
+ * @param[in] batch index of a batch of integration steps for this bin
+ * @param[out] seed for the given bin (never 0 since TRandom treats 0 as a request for a time seed)
+ */
+unsigned int GetBinSeed(const unsigned int seed, const int bin, const int batch = 0);
+/* @brief Returns seed for Pythia8::Pythia derived from the base seed; seeds of
+ * the neighbouring streams are decorrelated by splitmix64 hash
+ *
+ * @param[in] seed base seed
+ * @param[in] stream index of an independent stream of events (e.g. index of a shard or a thread)
+ * @param[out] seed from the range [1, 900000000] allowed by Pythia8
+ */
+int GetPythiaSeed(const unsigned int seed, const int stream);
+
+#endif /* RANDOM_SEED_HPP */
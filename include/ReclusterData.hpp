@@ -0,0 +1,29 @@
+/**
+ *  @file   ReclusterData.hpp
+ *  @brief  Contains reconstruction of jets from events stored by GenerateData without generating them again
+ *
+ *  This file is a part of a project HadronProcessesLO (https://github.com/Sergeyir/HadronProcessesLO).
+ *
+ *  @author Sergei Antsupov (antsupov0124@gmail.com)
+ **/
+#ifndef RECLUSTER_DATA_HPP
+#define RECLUSTER_DATA_HPP
+
+#include <iostream>
+#include <vector>
+#include <filesystem>
+#include <string>
+#include <cmath>
+
+#include "fastjet/PseudoJet.hh"
+#include "fastjet/ClusterSequence.hh"
+
+#include "yaml-cpp/yaml.h"
+
+#include "TFile.h"
+#include "TH1D.h"
+#include "TTree.h"
+
+#include "EventAnalysis.hpp"
+
+#endif /* RECLUSTER_DATA_HPP */
@@ -0,0 +1,60 @@
+/**
+ *  @file   SobolSequence.hpp
+ *  @brief  Contains declaration of class SobolSequence that generates scrambled Sobol low discrepancy points for quasi-Monte Carlo integration
+ *
+ *  This file is a part of a project HadronProcessesLO (https://github.com/Sergeyir/HadronProcessesLO).
+ *
+ *  @author Sergei Antsupov (antsupov0124@gmail.com)
+ **/
+#ifndef SOBOL_SEQUENCE_HPP
+#define SOBOL_SEQUENCE_HPP
+
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+/* @class SobolSequence
+ * @brief Sobol sequence in up to SobolSequence::maxDimension dimensions (direction numbers of S. Joe and F. Y. Kuo,
+ * SIAM J. Sci. Comput. 30 (2008) 2635) randomized with random linear scrambling and random digital shift
+ * (J. Matousek, J. Complexity 14 (1998) 527)
+ *
+ * Every randomized sequence stays a low discrepancy sequence while its points are uniformly
+ * distributed in the unit hypercube so integrals obtained with independently scrambled
+ * sequences (replicas) are independent unbiased estimates from which the uncertainty can be obtained.
+ * Balance properties are exact when the number of points is a power of 2.
+ */
+class SobolSequence
+{
+   public:
+
+   /// maximum number of dimensions
+   static constexpr int maxDimension = 10;
+
+   /* @brief Constructor; generates direction numbers and scrambles them
+    *
+    * @param[in] dimension number of dimensions
+    * @param[in] scrambleSeed seed from which scrambling matrices and digital shifts are derived
+    */
+   SobolSequence(const int dimension, const uint64_t scrambleSeed);
+   /* @brief Writes the next point of the sequence
+    *
+    * @param[in] point array in which dimension values from [0, 1) will be written
+    */
+   void Next(double *point);
+
+   private:
+
+   /// number of bits in the representation of coordinates
+   static constexpr int nBits = 32;
+   /// number of dimensions
+   int dimension;
+   /// index of the next point
+   uint32_t index = 0;
+   /// scrambled direction numbers; number k of dimension d is placed at d*nBits + k
+   std::vector<uint32_t> directions;
+   /// current coordinates as integers (Gray code order)
+   std::vector<uint32_t> current;
+};
+
+#endif /* SOBOL_SEQUENCE_HPP */
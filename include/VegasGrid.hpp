@@ -0,0 +1,65 @@
+/**
+ *  @file   VegasGrid.hpp
+ *  @brief  Contains declaration of class VegasGrid that is used for VEGAS adaptive importance sampling in MC integration
+ *
+ *  This file is a part of a project HadronProcessesLO (https://github.com/Sergeyir/HadronProcessesLO).
+ *
+ *  @author Sergei Antsupov (antsupov0124@gmail.com)
+ **/
+#ifndef VEGAS_GRID_HPP
+#define VEGAS_GRID_HPP
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+/* @class VegasGrid
+ * @brief Separable grid that maps uniformly distributed points from [0, 1]^d onto [0, 1]^d
+ * so that the points are concentrated where the integrand is large (G. P. Lepage, J. Comput. Phys. 27 (1978) 192)
+ *
+ * Every dimension is split into bins of equal probability; after every iteration the bins are
+ * rearranged so that their widths become smaller where the accumulated squared integrand is larger.
+ */
+class VegasGrid
+{
+   public:
+
+   /* @brief Constructor; initializes uniform grid
+    *
+    * @param[in] dimension number of integration variables
+    * @param[in] nBins number of bins in every dimension
+    */
+   VegasGrid(const int dimension, const int nBins = 50);
+   /* @brief Maps a point from a unit hypercube to the integration variables
+    *
+    * @param[in] u array of dimension uniformly distributed numbers from [0, 1]
+    * @param[in] x array in which dimension mapped values from [0, 1] will be written
+    * @param[in] bins array in which dimension indices of bins in which the point is placed will be written
+    * @param[out] jacobian of the mapping, i.e. the weight by which the integrand must be multiplied
+    */
+   double Map(const double *u, double *x, int *bins) const;
+   /* @brief Adds squared weighted integrand value to the bins in which the point was placed
+    *
+    * @param[in] bins array of dimension bin indices obtained with VegasGrid::Map
+    * @param[in] value squared product of the integrand and the jacobian
+    */
+   void Accumulate(const int *bins, const double value);
+   /* @brief Rearranges bins according to the accumulated values and resets them
+    *
+    * @param[in] alpha damping parameter; the larger it is the faster the grid adapts
+    */
+   void Refine(const double alpha = 1.5);
+
+   private:
+
+   /// number of integration variables
+   int dimension;
+   /// number of bins in every dimension
+   int nBins;
+   /// edges of bins; edge i of dimension d is placed at d*(nBins + 1) + i
+   std::vector<double> edges;
+   /// accumulated squared weighted integrand values; bin i of dimension d is placed at d*nBins + i
+   std::vector<double> accumulated;
+};
+
+#endif /* VEGAS_GRID_HPP */
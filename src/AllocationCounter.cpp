@@ -0,0 +1,47 @@
+/**
+ *  @file   AllocationCounter.cpp
+ *  @brief  Contains implementation of the counter of heap allocations that is used to check that event loops do not allocate memory
+ *
+ *  This file is a part of a project HadronProcessesLO (https://github.com/Sergeyir/HadronProcessesLO).
+ *
+ *  @author Sergei Antsupov (antsupov0124@gmail.com)
+ **/
+#ifndef ALLOCATION_COUNTER_CPP
+#define ALLOCATION_COUNTER_CPP
+
+#include <cstdlib>
+#include <new>
+
+#include "AllocationCounter.hpp"
+
+thread_local long allocationCount = 0;
+thread_local long jetAllocationCount = 0;
+thread_local long *allocationCounter = nullptr;
+std::atomic<long> totalAllocationCount{0};
+std::atomic<long> totalJetAllocationCount{0};
+
+// global operator new is replaced only if the program is compiled with COUNT_ALLOCATIONS
+// (cmake -DCOUNT_ALLOCATIONS=ON) since the check of the flag on every allocation is not free;
+// operator new[] and all other forms of new call this one by default; it is defined in its own 
+// translation unit so that the compiler does not mix it up with the built-in operator new
+#ifdef COUNT_ALLOCATIONS
+void *operator new(std::size_t size)
+{
+   if (allocationCounter) (*allocationCounter)++;
+   void *pointer = std::malloc((size > 0) ? size : 1);
+   if (!pointer) throw std::bad_alloc();
+   return pointer;
+}
+
+void operator delete(void *pointer) noexcept
+{
+   std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept
+{
+   std::free(pointer);
+}
+#endif /* COUNT_ALLOCATIONS */
+
+#endif /* ALLOCATION_COUNTER_CPP */
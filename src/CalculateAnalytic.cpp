@@ -11,14 +11,19 @@
 
 #include "CalculateAnalytic.hpp"
 
+// main is left out when this file is included by bench/Benchmark.cpp 
+// that calls the functions of the calculation directly
+#ifndef CALCULATE_ANALYTIC_NO_MAIN
 int main(int argc, char **argv)
 {
    // printing info on usage and exiting program if number of parameters is incorrect
-   if (argc != 3) 
+   if (argc < 3) 
    {
-      std::cout << "\033[1m\033[31mError:\033[0m Expected 2 parameters while " <<
+      std::cout << "\033[1m\033[31mError:\033[0m Expected at least 2 parameters while " <<
                    std::to_string(argc - 1) << " parameter(s) were provided \n"\
-                   "Usage: bin/CalculateAnalytic inputFileName.yaml numberOfIntegrationSteps" 
+                   "Usage: bin/CalculateAnalytic inputFileName.yaml numberOfIntegrationSteps "\
+                   "[--threads N] [--seed S] [--precision P] [--budget B] [--max-passes N] "\
+                   "[--checkpoint T] [--resume] [--no-cache]" 
                 << std::endl;
       std::cout << "[\033[1m\033[32mINFO\033[0m] input file example is located in input directory" 
                 << std::endl;
@@ -32,88 +37,985 @@ int main(int argc, char **argv)
       return 1;
    }
 
-   numberOfIntegrationSteps = std::stol(argv[2]);
+   // number of integration steps for every pT bin (in the first pass if the target precision is set)
+   // or the total number of phase space points in "events" analytic mode
+   const long numberOfPilotSteps = std::stol(argv[2]);
+   baseSeed = GetRandomSeed();
+   // target relative uncertainty of every pT bin; 0 means that only the first pass is performed
+   double targetPrecision = 0.;
+   // maximum total number of integration steps for all pT bins; 0 means no limit
+   long integrationStepsBudget = 0;
+
+   // reading optional parameters
+   for (int i = 3; i < argc; i++)
+   {
+      const std::string option = argv[i];
+      // options without values
+      if (option == "--resume")
+      {
+         resumeFromCheckpoint = true;
+         continue;
+      }
+      if (option == "--no-cache")
+      {
+         useResultCache = false;
+         continue;
+      }
+      if (i + 1 >= argc)
+      {
+         std::cout << "\033[1m\033[31mError:\033[0m no value was provided for option " << 
+                      option << std::endl;
+         return 1;
+      }
+      if (option == "--threads") numberOfThreads = std::stoul(argv[++i]);
+      else if (option == "--seed") 
+      {
+         baseSeed = std::stoul(argv[++i]);
+         isSeedSet = true;
+      }
+      else if (option == "--precision") targetPrecision = std::stod(argv[++i]);
+      else if (option == "--budget") integrationStepsBudget = std::stol(argv[++i]);
+      else if (option == "--max-passes") maxNumberOfPasses = std::stoi(argv[++i]);
+      else if (option == "--checkpoint") checkpointInterval = std::stod(argv[++i]);
+      else
+      {
+         std::cout << "\033[1m\033[31mError:\033[0m unknown option " << option << std::endl;
+         return 1;
+      }
+   }
+
+   // 0 threads means that all available cores will be used
+   if (numberOfThreads == 0) numberOfThreads = std::max(std::thread::hardware_concurrency(), 1u);
 
    // YAML::Node object reads all data from the .yaml file
    YAML::Node inputFileContents = YAML::LoadFile(argv[1]);
 
+   // with "scan" node in the input file every configuration of the grid of parameters 
+   // is calculated in this run and written to its own directory of the output file
+   std::vector<ScanConfiguration> configurations;
+   if (!ReadScanConfigurations(inputFileContents, configurations)) return 1;
+   const bool isScan = !configurations.front().name.empty();
+
+   if (isScan && (checkpointInterval > 0. || resumeFromCheckpoint))
+   {
+      std::cout << "\033[1m\033[31mError:\033[0m options --checkpoint and --resume are not "\
+                   "supported for input files with scan" << std::endl;
+      return 1;
+   }
+
+   // results of pT bins and the tasks that are left are restored first 
+   // since the checkpoint also contains the seed of the interrupted run
+   std::vector<PTBinResult> dSigmaDPT;
+   std::vector<PTBinTask> tasks;
+   if (resumeFromCheckpoint && !ReadPTBinCheckpoint(tasks, dSigmaDPT)) return 1;
+   lastCheckpointTime = std::chrono::steady_clock::now();
+
+   // seed is printed so that the run can be reproduced with option --seed
+   std::cout << "[\033[1m\033[32mINFO\033[0m] Using seed " << baseSeed << " and " << 
+                numberOfThreads << " thread(s)" << std::endl;
+
+   // ROOT needs to be notified that its objects will be used from multiple threads
+   ROOT::EnableThreadSafety();
+
+   std::filesystem::create_directory("output");
+   TFile outputFile("output/analytic.root", "RECREATE");
+
+   threadPDFs.assign(numberOfThreads, nullptr);
+
+   // configurations with the same pdf set are calculated one after another 
+   // so that every pdf set is loaded only once; their order is kept otherwise
+   std::vector<std::size_t> order(configurations.size());
+   std::vector<std::size_t> pdfSetGroups(configurations.size());
+   for (std::size_t i = 0; i < configurations.size(); i++)
+   {
+      order[i] = i;
+      pdfSetGroups[i] = i;
+      for (std::size_t j = 0; j < i; j++)
+      {
+         if (configurations[j].inputFileContents["pdfset"].as<std::string>() == 
+             configurations[i].inputFileContents["pdfset"].as<std::string>())
+         {
+            pdfSetGroups[i] = j;
+            break;
+         }
+      }
+   }
+   std::stable_sort(order.begin(), order.end(), [&](const std::size_t i, const std::size_t j) 
+                    {return pdfSetGroups[i] < pdfSetGroups[j];});
+
+   // seed of the cache of a configuration must not be used for the next ones
+   const unsigned int runSeed = baseSeed;
+   for (const std::size_t i : order)
+   {
+      if (isScan)
+      {
+         std::cout << "[\033[1m\033[32mINFO\033[0m] Configuration " << i + 1 << " of " << 
+                      configurations.size() << ": " << configurations[i].description << std::endl;
+         outputFile.mkdir(configurations[i].name.c_str(), 
+                          configurations[i].description.c_str())->cd();
+      }
+
+      if (!CalculateConfiguration(configurations[i].inputFileContents, numberOfPilotSteps, 
+                                  targetPrecision, integrationStepsBudget, tasks, dSigmaDPT)) 
+      {
+         return 1;
+      }
+
+      baseSeed = runSeed;
+      currentPass = 0;
+      numberOfUsedSteps = 0;
+      tasks.clear();
+      dSigmaDPT.clear();
+   }
+
+   for (LHAPDF::PDF *threadPDF : threadPDFs) delete threadPDF;
+   delete pdfGrid;
+
+   outputFile.Close();
+
+   // checkpoint is not needed after the output is written
+   std::filesystem::remove(checkpointFileName);
+
+   return 0;
+}
+#endif /* CALCULATE_ANALYTIC_NO_MAIN */
+
+bool CalculateConfiguration(const YAML::Node& inputFileContents, const long numberOfPilotSteps, 
+                            const double targetPrecision, const long integrationStepsBudget, 
+                            std::vector<PTBinTask>& tasks, std::vector<PTBinResult>& dSigmaDPT)
+{
    const std::string pdfSet = inputFileContents["pdfset"].as<std::string>();
    const double pTHatMin = inputFileContents["pthatmin"].as<double>();
    const double absMaxY = inputFileContents["abs_max_y"].as<double>();
    const double sqrtSNN = inputFileContents["energy"].as<double>();
 
-   pdf = LHAPDF::mkPDF(pdfSet);
-   rnd.SetSeed(GetRandomSeed());
+   // integration method: "plain" (uniform MC) or "vegas" (adaptive importance sampling)
+   if (inputFileContents["integrator"])
+   {
+      integrationMethod = inputFileContents["integrator"].as<std::string>();
+      if (integrationMethod != "plain" && integrationMethod != "vegas" && 
+          integrationMethod != "qmc")
+      {
+         std::cout << "\033[1m\033[31mError:\033[0m unknown integrator " << 
+                      integrationMethod << std::endl;
+         return false;
+      }
+   }
+   if (inputFileContents["vegas_iterations"]) 
+   {
+      numberOfVegasIterations = inputFileContents["vegas_iterations"].as<int>();
+   }
+   if (inputFileContents["vegas_bins"]) 
+   {
+      numberOfVegasBins = inputFileContents["vegas_bins"].as<int>();
+   }
+   if (inputFileContents["qmc_replicas"]) 
+   {
+      numberOfQMCReplicas = inputFileContents["qmc_replicas"].as<int>();
+   }
+
+   // analytic mode: "bins" (d\sigma / dp_T is integrated in every pT bin separately) or "events" 
+   // (phase space points are sampled once and fill all histograms defined in the input file)
+   std::vector<ObservableHistogram> observableHistograms;
+   if (inputFileContents["analytic_mode"]) 
+   {
+      analyticMode = inputFileContents["analytic_mode"].as<std::string>();
+   }
+   if (analyticMode == "events")
+   {
+      if (!inputFileContents["histograms"])
+      {
+         std::cout << "\033[1m\033[31mError:\033[0m no histograms were defined for "\
+                      "analytic_mode \"events\"" << std::endl;
+         return false;
+      }
+      if (!ReadObservableHistograms(inputFileContents["histograms"], observableHistograms)) 
+      {
+         return false;
+      }
+      if (inputFileContents["pt_sampling_power"]) 
+      {
+         pTSamplingPower = inputFileContents["pt_sampling_power"].as<double>();
+      }
+      if (targetPrecision > 0.)
+      {
+         std::cout << "\033[1m\033[31mError:\033[0m option --precision is not supported for "\
+                      "analytic_mode \"events\"" << std::endl;
+         return false;
+      }
+      // points are always sampled as described in ProcessEventChunks
+      if (integrationMethod != "plain")
+      {
+         std::cout << "\033[1m\033[31mError:\033[0m integrator " << integrationMethod << 
+                      " is not supported for analytic_mode \"events\"; use \"plain\"" << std::endl;
+         return false;
+      }
+      if (checkpointInterval > 0. || resumeFromCheckpoint)
+      {
+         std::cout << "\033[1m\033[31mError:\033[0m options --checkpoint and --resume are not "\
+                      "supported for analytic_mode \"events\"" << std::endl;
+         return false;
+      }
+   }
+   else if (analyticMode != "bins")
+   {
+      std::cout << "\033[1m\033[31mError:\033[0m unknown analytic_mode " << 
+                   analyticMode << std::endl;
+      return false;
+   }
 
-   std::filesystem::create_directory("output");
-   TFile outputFile("output/analytic.root", "RECREATE");
+   // pdf objects of threads and the pdf grid are kept for the next configurations 
+   // of a scan with the same pdf set so that the set is loaded only once
+   if (pdfSet != pdfSetOfThreadPDFs)
+   {
+      for (LHAPDF::PDF *&threadPDF : threadPDFs) 
+      {
+         delete threadPDF;
+         threadPDF = nullptr;
+      }
+      delete pdfGrid;
+      pdfGrid = nullptr;
+      pdfSetOfThreadPDFs = pdfSet;
+   }
+
+   // pdf backend: "lhapdf" (default) calls LHAPDF for every point, "grid" tabulates 
+   // the pdf set once in memory and interpolates it (see PDFGrid), and "dummy" tabulates 
+   // a simple parametrization instead of the pdf set so that no pdf set files are needed
+   const std::string pdfBackend = inputFileContents["pdf_backend"] ? 
+                                  inputFileContents["pdf_backend"].as<std::string>() : "lhapdf";
 
    TH1D distrDSigmaDPT("dsigmadpT", "d#sigma/dp_{T}", 1000 + pTHatMin, 0., 100. + pTHatMin);
 
    const int nBinsX = distrDSigmaDPT.GetXaxis()->GetNbins();
-   for (int i = 1; i <= nBinsX; i++)
+
+   // pdfs are evaluated at Q^2 = pT^2 from the centre of the first bin of dsigmadpT 
+   // (which is below pTHatMin) in "bins" mode and from pTHatMin in "events" mode
+   const double minPT = (analyticMode == "events") ? 
+                        pTHatMin : distrDSigmaDPT.GetXaxis()->GetBinCenter(1);
+   const double Q2Min = minPT*minPT;
+
+   if (pdfBackend == "grid")
    {
-      // the line below prints progress in percents
-      std::cout << static_cast<double>(i)/static_cast<double>(nBinsX)*100. << "%\r";
+      // pdf of the main thread is not used with the grid so it serves as the source of the grid;
+      // the grid of the previous configuration of a scan is rebuilt if it does not cover Q2Min
+      if (!threadPDFs[0]) threadPDFs[0] = LHAPDF::mkPDF(pdfSet);
+      if (pdfGrid && pdfGrid->GetQ2Min() > Q2Min)
+      {
+         delete pdfGrid;
+         pdfGrid = nullptr;
+      }
+      if (!pdfGrid) pdfGrid = new PDFGrid(threadPDFs[0], Q2Min);
 
-      double err;
-      const double dSigmaDPT = GetDSigmaDPT(distrDSigmaDPT.GetXaxis()->GetBinCenter(i), sqrtSNN, absMaxY, err);
+      // interpolated values are checked against LHAPDF in the whole Q^2 range of the calculation
+      const double tolerance = inputFileContents["pdf_grid_tolerance"] ? 
+                               inputFileContents["pdf_grid_tolerance"].as<double>() : 1e-3;
+      const double deviation = pdfGrid->GetMaxDeviation(threadPDFs[0], 10000, 
+                                                        Q2Min, sqrtSNN*sqrtSNN/4.);
 
-      distrDSigmaDPT.SetBinContent(i, dSigmaDPT);
-      distrDSigmaDPT.SetBinError(i, err);
+      if (deviation > tolerance)
+      {
+         std::cout << "\033[1m\033[31mError:\033[0m pdf grid deviates from LHAPDF by " << 
+                      deviation << " which is larger than the tolerance " << tolerance << std::endl;
+         return false;
+      }
+      std::cout << "[\033[1m\033[32mINFO\033[0m] pdf grid deviates from LHAPDF by at most " << 
+                   deviation << std::endl;
+   }
+   else if (pdfBackend == "dummy")
+   {
+      // pdf set is not read; the grid is rebuilt for the next configuration
+      delete pdfGrid;
+      pdfGrid = new PDFGrid();
+      pdfSetOfThreadPDFs.clear();
+   }
+   else if (pdfBackend == "lhapdf")
+   {
+      // grid of the previous configuration of a scan must not replace LHAPDF
+      delete pdfGrid;
+      pdfGrid = nullptr;
+   }
+   else
+   {
+      std::cout << "\033[1m\033[31mError:\033[0m unknown pdf_backend " << pdfBackend << std::endl;
+      return false;
+   }
+
+   if (analyticMode == "events")
+   {
+      // one pass over the phase space fills all histograms
+      RunEventIntegration(pdfSet, sqrtSNN, absMaxY, pTHatMin, 
+                          numberOfPilotSteps, observableHistograms);
+
+      for (const ObservableHistogram &histogram : observableHistograms) histogram.Write();
+
+      // every point falls into one of the bins (including underflow and overflow) 
+      // of every histogram so sum of all weights is the total cross section
+      double sigma = 0.;
+      for (const double weight : observableHistograms.front().sumOfWeights) sigma += weight;
+      std::cout << sigma << std::endl;
+
+      return true;
+   }
+
+   // results in pT bins depend only on these parameters; runs with the same parameters 
+   // share the cache so that every run only adds new integration steps to the previous ones
+   std::ostringstream configuration;
+   configuration.precision(std::numeric_limits<double>::max_digits10);
+   configuration << "energy=" << sqrtSNN << ";pdfset=" << pdfSet << ";abs_max_y=" << absMaxY << 
+                    ";pthatmin=" << pTHatMin << ";bins=" << nBinsX << "," << 
+                    distrDSigmaDPT.GetXaxis()->GetXmin() << "," << 
+                    distrDSigmaDPT.GetXaxis()->GetXmax() << ";integrator=" << integrationMethod << 
+                    ";pdf_backend=" << pdfBackend;
+   const std::string cacheFileName = GetResultCacheFileName(configuration.str());
+
+   // threads write results in dSigmaDPT instead of the histogram 
+   // since TH1::SetBinContent is not thread safe
+   if (resumeFromCheckpoint)
+   {
+      // the interrupted pass is continued with the tasks that were left
+      if (checkpointConfiguration != configuration.str() || 
+          dSigmaDPT.size() != static_cast<std::size_t>(nBinsX))
+      {
+         std::cout << "\033[1m\033[31mError:\033[0m checkpoint was written for "\
+                      "a different configuration: " << checkpointConfiguration << std::endl;
+         return false;
+      }
+   }
+   else
+   {
+      checkpointConfiguration = configuration.str();
+      dSigmaDPT.resize(nBinsX);
+      if (useResultCache && std::filesystem::exists(cacheFileName) && 
+          !ReadPTBinCache(cacheFileName, configuration.str(), dSigmaDPT)) return false;
+
+      // first pass: every pT bin gets the same number of integration steps; bins from the cache 
+      // only get the steps they lack and are skipped if they already reached the target precision
+      for (int i = 1; i <= nBinsX; i++)
+      {
+         const PTBinResult &result = dSigmaDPT[i - 1];
+         if (result.nSteps >= numberOfPilotSteps) continue;
+         if (targetPrecision > 0. && result.nSteps > 0 && 
+             result.GetRelativeError() <= targetPrecision) continue;
+
+         tasks.push_back({i, numberOfPilotSteps - result.nSteps, currentPass});
+         numberOfUsedSteps += numberOfPilotSteps - result.nSteps;
+      }
+   }
+   RunPTBinTasks(pdfSet, distrDSigmaDPT.GetXaxis(), sqrtSNN, absMaxY, tasks, dSigmaDPT);
+
+   // next passes: additional batches of integration steps are given to the bins that have not 
+   // reached the target precision, starting from the worst ones, until the budget is spent
+   // or maxNumberOfPasses passes are performed
+   int numberOfPasses = 0;
+   for (currentPass++; targetPrecision > 0.; currentPass++)
+   {
+      if (numberOfPasses++ >= maxNumberOfPasses)
+      {
+         std::cout << "[\033[1m\033[32mINFO\033[0m] Maximum number of passes " << 
+                      maxNumberOfPasses << " was reached" << std::endl;
+         break;
+      }
+
+      std::vector<int> bins;
+      for (int i = 1; i <= nBinsX; i++)
+      {
+         if (dSigmaDPT[i - 1].GetRelativeError() > targetPrecision) bins.push_back(i);
+      }
+      std::stable_sort(bins.begin(), bins.end(), [&](const int bin1, const int bin2) 
+                       {return dSigmaDPT[bin1 - 1].GetRelativeError() > 
+                               dSigmaDPT[bin2 - 1].GetRelativeError();});
+
+      tasks.clear();
+      for (const int bin : bins)
+      {
+         // for MC the uncertainty decreases as 1/\sqrt{N} which gives an estimate of the number 
+         // of steps needed; it is limited since the uncertainty itself is estimated with errors
+         const PTBinResult &result = dSigmaDPT[bin - 1];
+         const double ratio = result.GetRelativeError()/targetPrecision;
+         // the upper limit is applied to the double so that the conversion can not overflow
+         const double maxSteps = std::min(8.*static_cast<double>(result.nSteps), 
+                                          static_cast<double>(maxBatchSteps));
+         long nSteps = static_cast<long>(std::clamp(1.1*static_cast<double>(result.nSteps)*
+                                                    (ratio*ratio - 1.), 
+                                                    std::min(static_cast<double>(numberOfPilotSteps), 
+                                                             maxSteps), maxSteps));
+
+         if (integrationStepsBudget > 0)
+         {
+            nSteps = std::min(nSteps, integrationStepsBudget - numberOfUsedSteps);
+         }
+         if (nSteps <= 0) break;
+
+         tasks.push_back({bin, nSteps, currentPass});
+         numberOfUsedSteps += nSteps;
+      }
+      if (tasks.empty()) break;
+
+      std::cout << "[\033[1m\033[32mINFO\033[0m] Pass " << currentPass + 1 << ": " << bins.size() << 
+                   " bins have not reached the target precision; " << tasks.size() << 
+                   " of them get additional integration steps" << std::endl;
+      RunPTBinTasks(pdfSet, distrDSigmaDPT.GetXaxis(), sqrtSNN, absMaxY, tasks, dSigmaDPT);
+   }
+
+   if (targetPrecision > 0.)
+   {
+      int numberOfUnconvergedBins = 0;
+      for (const PTBinResult &result : dSigmaDPT)
+      {
+         if (result.GetRelativeError() > targetPrecision) numberOfUnconvergedBins++;
+      }
+      std::cout << "[\033[1m\033[32mINFO\033[0m] " << numberOfUsedSteps << 
+                   " integration steps were used; " << numberOfUnconvergedBins << 
+                   " bins have not reached the target precision" << std::endl;
+   }
+
+   for (int i = 1; i <= nBinsX; i++)
+   {
+      distrDSigmaDPT.SetBinContent(i, dSigmaDPT[i - 1].GetValue());
+      distrDSigmaDPT.SetBinError(i, dSigmaDPT[i - 1].GetError());
    }
 
    distrDSigmaDPT.Write();
 
    std::cout << distrDSigmaDPT.Integral() << std::endl;
 
-   outputFile.Close();
+   // the next run with the same configuration continues from these results;
+   // currentPass is the index of the first pass that was not performed
+   if (useResultCache) WritePTBinCache(cacheFileName, configuration.str(), dSigmaDPT);
 
-   return 0;
+   return true;
 }
 
-double GetDSigmaDOmega(const int id1, const int id2, const double pT, 
-                       const double s, const double y)
+void RunPTBinTasks(const std::string& pdfSet, const TAxis *pTAxis, 
+                   const double sqrtSNN, const double absYMax, 
+                   const std::vector<PTBinTask>& tasks, std::vector<PTBinResult>& results)
 {
-   // to do: define mandelstam variables (t, u) and substitute lower random dummies for them
-   // (hint: it will be easier if you define cos(\Theta) first)
-   const double t = rnd.Uniform(-s, s);
-   const double u = rnd.Uniform(-s, s);
-   
-   // obtaining alpha_{S} at hard scale, i.e. \mu_F = p_T
-   const double alphaS = pdf->alphasQ2(pT*pT);
+   nextPTBinTask = 0;
+   numberOfProcessedPTBinTasks = 0;
+   isPTBinTaskDone.assign(tasks.size(), 0);
+
+   std::vector<std::thread> threads;
+   for (unsigned int i = 1; i < numberOfThreads; i++)
+   {
+      threads.emplace_back(ProcessPTBins, i, std::cref(pdfSet), pTAxis, sqrtSNN, absYMax, 
+                           std::cref(tasks), std::ref(results));
+   }
+   // main thread also takes part in the calculation
+   ProcessPTBins(0, pdfSet, pTAxis, sqrtSNN, absYMax, tasks, results);
+   for (std::thread& thread : threads) thread.join();
+
+   // the next pass is planned from the results of all bins so the checkpoint
+   // after the pass does not contain any tasks
+   if (checkpointInterval > 0.) WritePTBinCheckpoint(tasks, results);
+}
+
+void ProcessPTBins(const unsigned int threadIndex, const std::string& pdfSet, 
+                   const TAxis *pTAxis, const double sqrtSNN, const double absYMax, 
+                   const std::vector<PTBinTask>& tasks, std::vector<PTBinResult>& results)
+{
+   SetThreadPDF(threadIndex, pdfSet);
+
+   const int nTasks = static_cast<int>(tasks.size());
+   for (int i = nextPTBinTask++; i < nTasks; i = nextPTBinTask++)
+   {
+      const PTBinTask &task = tasks[i];
+
+      // random number sequence depends only on the bin, the batch, and the base seed 
+      // which makes the result independent of the order in which bins are processed
+      rnd.SetSeed(GetBinSeed(baseSeed, task.bin, task.batch));
+      numberOfIntegrationSteps = task.nSteps;
+
+      double err;
+      const double dSigmaDPT = GetDSigmaDPT(pTAxis->GetBinCenter(task.bin), 
+                                            sqrtSNN, absYMax, err);
+      // every bin appears only once in the list of tasks but the results are still added 
+      // under the lock so that the checkpoint only contains results of complete tasks
+      std::lock_guard<std::mutex> lock(threadsMutex);
+      results[task.bin - 1].Add(dSigmaDPT, err, task.nSteps);
+      isPTBinTaskDone[i] = 1;
+
+      if (checkpointInterval > 0. && 
+          std::chrono::duration<double>(std::chrono::steady_clock::now() - 
+                                        lastCheckpointTime).count() > checkpointInterval)
+      {
+         WritePTBinCheckpoint(tasks, results);
+         lastCheckpointTime = std::chrono::steady_clock::now();
+      }
+
+      // the line below prints progress in percents
+      std::cout << static_cast<double>(++numberOfProcessedPTBinTasks)/
+                   static_cast<double>(nTasks)*100. << "%\r" << std::flush;
+   }
+
+   pdf = nullptr;
+}
+
+void WritePTBinCheckpoint(const std::vector<PTBinTask>& tasks, 
+                          const std::vector<PTBinResult>& results)
+{
+   const std::string temporaryFileName = checkpointFileName + ".tmp";
+
+   // values are written with all significant digits so that they are restored exactly
+   std::ofstream checkpointFile(temporaryFileName);
+   checkpointFile.precision(std::numeric_limits<double>::max_digits10);
+
+   checkpointFile << "configuration " << checkpointConfiguration << std::endl;
+   checkpointFile << "seed " << baseSeed << std::endl;
+   checkpointFile << "pass " << currentPass << " " << numberOfUsedSteps << std::endl;
+   checkpointFile << "sums " << results.size() << std::endl;
+   for (const PTBinResult &result : results)
+   {
+      checkpointFile << result.sum << " " << result.sum2 << " " << result.nSteps << std::endl;
+   }
+
+   long numberOfTasksLeft = 0;
+   for (const char isDone : isPTBinTaskDone) if (!isDone) numberOfTasksLeft++;
+   checkpointFile << "tasks " << numberOfTasksLeft << std::endl;
+   for (std::size_t i = 0; i < tasks.size(); i++)
+   {
+      if (isPTBinTaskDone[i]) continue;
+      checkpointFile << tasks[i].bin << " " << tasks[i].nSteps << " " << 
+                        tasks[i].batch << std::endl;
+   }
+   checkpointFile.close();
+
+   // renaming is atomic so the previous checkpoint is replaced only by a complete one
+   std::filesystem::rename(temporaryFileName, checkpointFileName);
+}
+
+bool ReadPTBinCheckpoint(std::vector<PTBinTask>& tasks, std::vector<PTBinResult>& results)
+{
+   if (!std::filesystem::exists(checkpointFileName))
+   {
+      std::cout << "\033[1m\033[31mError:\033[0m checkpoint " << checkpointFileName << 
+                   " was not found" << std::endl;
+      return false;
+   }
+
+   std::ifstream checkpointFile(checkpointFileName);
+   std::string configurationKey, seedKey, passKey, sumsKey, tasksKey;
+   std::size_t numberOfBins, numberOfTasks;
+
+   checkpointFile >> configurationKey;
+   std::getline(checkpointFile >> std::ws, checkpointConfiguration);
+   checkpointFile >> seedKey >> baseSeed >> passKey >> currentPass >> numberOfUsedSteps >> 
+                     sumsKey >> numberOfBins;
+   results.resize(numberOfBins);
+   for (PTBinResult &result : results)
+   {
+      checkpointFile >> result.sum >> result.sum2 >> result.nSteps;
+   }
+   checkpointFile >> tasksKey >> numberOfTasks;
+   tasks.resize(numberOfTasks);
+   for (PTBinTask &task : tasks) checkpointFile >> task.bin >> task.nSteps >> task.batch;
+
+   if (!checkpointFile || configurationKey != "configuration" || 
+       seedKey != "seed" || passKey != "pass" || 
+       sumsKey != "sums" || tasksKey != "tasks")
+   {
+      std::cout << "\033[1m\033[31mError:\033[0m file " << checkpointFileName << 
+                   " is not a correct checkpoint" << std::endl;
+      return false;
+   }
+
+   std::cout << "[\033[1m\033[32mINFO\033[0m] Resuming pass " << currentPass + 1 << 
+                " from the checkpoint; " << numberOfTasks << " tasks are left" << std::endl;
+   return true;
+}
+
+std::string GetResultCacheFileName(const std::string& configuration)
+{
+   // FNV-1a hash of the configuration
+   uint64_t hash = 0xcbf29ce484222325ULL;
+   for (const char c : configuration)
+   {
+      hash ^= static_cast<unsigned char>(c);
+      hash *= 0x100000001b3ULL;
+   }
+
+   std::ostringstream fileName;
+   fileName << "output/analytic_cache_" << std::hex << std::setw(16) << 
+               std::setfill('0') << hash << ".txt";
+   return fileName.str();
+}
+
+void WritePTBinCache(const std::string& fileName, const std::string& configuration,
+                     const std::vector<PTBinResult>& results)
+{
+   const std::string temporaryFileName = fileName + ".tmp";
+
+   // values are written with all significant digits so that they are restored exactly
+   std::ofstream cacheFile(temporaryFileName);
+   cacheFile.precision(std::numeric_limits<double>::max_digits10);
 
-   // only qq->qq is shown below as an example
-   if (id1 != 0 && id2 != 0 && id1 == id2)
+   // configuration is written in full so that a collision of hashes is detected
+   cacheFile << "configuration " << configuration << std::endl;
+   cacheFile << "seed " << baseSeed << std::endl;
+   cacheFile << "passes " << currentPass << std::endl;
+   cacheFile << "sums " << results.size() << std::endl;
+   for (const PTBinResult &result : results)
    {
-      // source: Eq. 51.7 at https://pdg.lbl.gov/2025/reviews/contents_sports.html
-      return alphaS*alphaS/(9.*s)*((t*t + s*s)/(u*u) + (s*s + u*u)/(t*t) - 2.*s*s/(3.*u*t));
+      cacheFile << result.sum << " " << result.sum2 << " " << result.nSteps << std::endl;
    }
-   // to do: add other d\sigma / d\Omega processes here
+   cacheFile.close();
 
-   return 0.;
+   std::filesystem::rename(temporaryFileName, fileName);
+}
+
+bool ReadPTBinCache(const std::string& fileName, const std::string& configuration,
+                    std::vector<PTBinResult>& results)
+{
+   std::ifstream cacheFile(fileName);
+   std::string configurationKey, cachedConfiguration, seedKey, passesKey, sumsKey;
+   std::size_t numberOfBins = 0;
+   unsigned int cachedSeed;
+
+   // new batches of integration steps of this run get seeds of the passes 
+   // with indices starting from the number of passes of the previous runs
+   cacheFile >> configurationKey;
+   std::getline(cacheFile >> std::ws, cachedConfiguration);
+   cacheFile >> seedKey >> cachedSeed >> passesKey >> currentPass >> sumsKey >> numberOfBins;
+   if (!cacheFile || configurationKey != "configuration" || seedKey != "seed" || 
+       passesKey != "passes" || sumsKey != "sums")
+   {
+      std::cout << "\033[1m\033[31mError:\033[0m file " << fileName << 
+                   " is not a correct cache; remove it or use option --no-cache" << std::endl;
+      return false;
+   }
+   if (cachedConfiguration != configuration || numberOfBins != results.size())
+   {
+      std::cout << "\033[1m\033[31mError:\033[0m cache " << fileName << 
+                   " was written for a different configuration; remove it or use option "\
+                   "--no-cache" << std::endl;
+      return false;
+   }
+
+   // new points must come from the continuation of the random number sequences of the cache
+   // so a different seed set with option --seed can not be used with it
+   if (isSeedSet && cachedSeed != baseSeed)
+   {
+      std::cout << "\033[1m\033[31mError:\033[0m cache " << fileName << 
+                   " was written with seed " << cachedSeed << " while seed " << baseSeed << 
+                   " was set; run without option --seed to continue it, remove it, "\
+                   "or use option --no-cache" << std::endl;
+      return false;
+   }
+
+   for (PTBinResult &result : results)
+   {
+      cacheFile >> result.sum >> result.sum2 >> result.nSteps;
+   }
+   if (!cacheFile)
+   {
+      std::cout << "\033[1m\033[31mError:\033[0m cache " << fileName << 
+                   " is incomplete; remove it or use option --no-cache" << std::endl;
+      return false;
+   }
+
+   baseSeed = cachedSeed;
+
+   long numberOfCachedSteps = 0;
+   for (const PTBinResult &result : results) numberOfCachedSteps += result.nSteps;
+   std::cout << "[\033[1m\033[32mINFO\033[0m] Continuing from " << numberOfCachedSteps << 
+                " integration steps of " << currentPass << " previous pass(es) read from " << 
+                fileName << "; seed " << baseSeed << " of the cache is used" << std::endl;
+   return true;
+}
+
+void SetThreadPDF(const unsigned int threadIndex, const std::string& pdfSet)
+{
+   // LHAPDF::PDF objects are not guaranteed to be thread safe so every thread gets its own one;
+   // their creation is serialized since LHAPDF reads and caches the pdf set files;
+   // they are kept between passes and are not needed if pdfGrid is used
+   if (pdfGrid) return;
+
+   std::lock_guard<std::mutex> lock(threadsMutex);
+   if (!threadPDFs[threadIndex]) threadPDFs[threadIndex] = LHAPDF::mkPDF(pdfSet);
+   pdf = threadPDFs[threadIndex];
+}
+
+bool ReadObservableHistograms(const YAML::Node& node, std::vector<ObservableHistogram>& histograms)
+{
+   // returns index of the observable with the given name or -1 if there is no such observable
+   auto getObservable = [](const std::string& name) -> int
+   {
+      for (int i = 0; i < numberOfObservables; i++)
+      {
+         if (observableNames[i] == name) return i;
+      }
+      return -1;
+   };
+
+   for (const YAML::Node& entry : node)
+   {
+      ObservableHistogram histogram;
+      histogram.name = entry["name"].as<std::string>();
+      histogram.title = entry["title"] ? entry["title"].as<std::string>() : histogram.name;
+
+      histogram.observableX = getObservable(entry["x"]["observable"].as<std::string>());
+      histogram.nBinsX = entry["x"]["bins"].as<int>();
+      histogram.minX = entry["x"]["min"].as<double>();
+      histogram.maxX = entry["x"]["max"].as<double>();
+      if (entry["y"])
+      {
+         histogram.observableY = getObservable(entry["y"]["observable"].as<std::string>());
+         histogram.nBinsY = entry["y"]["bins"].as<int>();
+         histogram.minY = entry["y"]["min"].as<double>();
+         histogram.maxY = entry["y"]["max"].as<double>();
+         if (histogram.observableY < 0)
+         {
+            std::cout << "\033[1m\033[31mError:\033[0m unknown observable " << 
+                         entry["y"]["observable"].as<std::string>() << " in histogram " << 
+                         histogram.name << std::endl;
+            return false;
+         }
+      }
+      if (histogram.observableX < 0)
+      {
+         std::cout << "\033[1m\033[31mError:\033[0m unknown observable " << 
+                      entry["x"]["observable"].as<std::string>() << " in histogram " << 
+                      histogram.name << std::endl;
+         return false;
+      }
+      if (histogram.nBinsX < 1 || histogram.nBinsY < 1 || 
+          histogram.maxX <= histogram.minX || histogram.maxY <= histogram.minY)
+      {
+         std::cout << "\033[1m\033[31mError:\033[0m incorrect binning of histogram " << 
+                      histogram.name << std::endl;
+         return false;
+      }
+      histogram.Reset();
+      histograms.push_back(histogram);
+   }
+   return true;
+}
+
+void RunEventIntegration(const std::string& pdfSet, const double sqrtSNN, const double absYMax,
+                         const double pTHatMin, const long nSteps,
+                         std::vector<ObservableHistogram>& histograms)
+{
+   nextEventChunk = 0;
+   nextEventChunkToMerge = 0;
+
+   std::vector<std::thread> threads;
+   for (unsigned int i = 1; i < numberOfThreads; i++)
+   {
+      threads.emplace_back(ProcessEventChunks, i, std::cref(pdfSet), sqrtSNN, absYMax, 
+                           pTHatMin, nSteps, std::ref(histograms));
+   }
+   // main thread also takes part in the calculation
+   ProcessEventChunks(0, pdfSet, sqrtSNN, absYMax, pTHatMin, nSteps, histograms);
+   for (std::thread& thread : threads) thread.join();
+}
+
+void ProcessEventChunks(const unsigned int threadIndex, const std::string& pdfSet,
+                        const double sqrtSNN, const double absYMax, const double pTHatMin,
+                        const long nSteps, std::vector<ObservableHistogram>& histograms)
+{
+   SetThreadPDF(threadIndex, pdfSet);
+
+   // every chunk is filled into its own copy of histograms first
+   std::vector<ObservableHistogram> chunkHistograms = histograms;
+
+   // pT is sampled from pTHatMin to the kinematic limit and y1 and y2 uniformly
+   const double pTMax = sqrtSNN/2.;
+   const double areaY = 4.*absYMax*absYMax;
+
+   thread_local double pTs[integrationBlockSize], y1s[integrationBlockSize], 
+                       y2s[integrationBlockSize], jacobians[integrationBlockSize], 
+                       values[integrationBlockSize];
+   double observables[numberOfObservables];
+
+   const long nChunks = (nSteps + eventChunkSize - 1)/eventChunkSize;
+   for (long chunk = nextEventChunk++; chunk < nChunks; chunk = nextEventChunk++)
+   {
+      for (ObservableHistogram &histogram : chunkHistograms) histogram.Reset();
+
+      // random number sequence depends only on the chunk and the base seed 
+      rnd.SetSeed(GetBinSeed(baseSeed, static_cast<int>(chunk)));
+
+      const long chunkSteps = std::min(eventChunkSize, nSteps - chunk*eventChunkSize);
+      for (long i = 0; i < chunkSteps; i += integrationBlockSize)
+      {
+         const int n = static_cast<int>(std::min(static_cast<long>(integrationBlockSize), 
+                                                 chunkSteps - i));
+         for (int k = 0; k < n; k++)
+         {
+            pTs[k] = SamplePowerLaw(rnd.Rndm(), pTHatMin, pTMax, pTSamplingPower, jacobians[k]);
+            y1s[k] = rnd.Uniform(-absYMax, absYMax);
+            y2s[k] = rnd.Uniform(-absYMax, absYMax);
+         }
+
+         GetDSigmaDPTDY1DY2Block(pTs, y1s, y2s, sqrtSNN, values, n);
+
+         for (int k = 0; k < n; k++)
+         {
+            // kinematically forbidden points give 0 and do not need to be filled
+            if (values[k] == 0.) continue;
+
+            // integral of d\sigma over the whole phase space is the sum of weights of all points
+            const double weight = values[k]*jacobians[k]*areaY/static_cast<double>(nSteps);
+            GetObservables(pTs[k], sqrtSNN, y1s[k], y2s[k], observables);
+            for (ObservableHistogram &histogram : chunkHistograms) 
+            {
+               histogram.Fill(observables, weight);
+            }
+         }
+      }
+
+      // chunks are added in their order so that the sums do not depend on the number of threads;
+      // chunks are taken in the same order so the waiting is short
+      std::unique_lock<std::mutex> lock(threadsMutex);
+      eventChunkMerged.wait(lock, [&] {return nextEventChunkToMerge == chunk;});
+      for (unsigned int i = 0; i < histograms.size(); i++) histograms[i].Add(chunkHistograms[i]);
+      nextEventChunkToMerge++;
+      eventChunkMerged.notify_all();
+
+      // the line below prints progress in percents
+      std::cout << static_cast<double>(nextEventChunkToMerge)/
+                   static_cast<double>(nChunks)*100. << "%\r" << std::flush;
+   }
+
+   pdf = nullptr;
+}
+
+double SamplePowerLaw(const double u, const double min, const double max,
+                      const double power, double &jacobian)
+{
+   // inverse of the cumulative distribution function of value^{-power}
+   if (fabs(power - 1.) < 1e-9)
+   {
+      const double value = min*pow(max/min, u);
+      jacobian = value*log(max/min);
+      return value;
+   }
+   const double exponent = 1. - power;
+   const double lowerTerm = pow(min, exponent);
+   const double upperTerm = pow(max, exponent);
+   const double value = pow(lowerTerm + u*(upperTerm - lowerTerm), 1./exponent);
+   jacobian = (upperTerm - lowerTerm)/exponent*pow(value, power);
+   return value;
+}
+
+void GetObservables(const double pT, const double sqrtSNN, const double y1, const double y2,
+                    double *observables)
+{
+   observables[pTObservable] = pT;
+   observables[y1Observable] = y1;
+   observables[y2Observable] = y2;
+   observables[deltaYObservable] = y1 - y2;
+   observables[yBoostObservable] = (y1 + y2)/2.;
+   observables[x1Observable] = GetX1(pT, sqrtSNN, y1, y2);
+   observables[x2Observable] = GetX2(pT, sqrtSNN, y1, y2);
+   // \hat{s} = x1*x2*s_{NN}
+   observables[massObservable] = sqrtSNN*sqrt(observables[x1Observable]*observables[x2Observable]);
+}
+
+double GetDSigmaDOmega(const int processClass, const double alphaS, 
+                       const double s, const double t, const double u)
+{
+   // squared matrix elements averaged over initial and summed over final spins and colours 
+   // in units of g^4 (source: Eq. 51.4 - 51.12 at https://pdg.lbl.gov/2025/reviews/contents_sports.html);
+   // for every class they are summed over both orderings of the final partons (parton 1 at 
+   // angle \Theta and parton 2 at angle \pi - \Theta) so that every outgoing parton is counted 
+   // as in the distribution of outgoing partons of GenerateData; for identical final partons 
+   // both orderings are already contained in the matrix element and no factor 1/2 is applied
+   const double s2 = s*s, t2 = t*t, u2 = u*u;
+   double matrixElement2 = 0.;
+
+   switch (processClass)
+   {
+      case qqPrimeProcess:
+         // qq' -> qq' and qq' -> q'q
+         matrixElement2 = 4./9.*((s2 + u2)/t2 + (s2 + t2)/u2);
+         break;
+      case qqProcess:
+         // qq -> qq
+         matrixElement2 = 4./9.*((s2 + u2)/t2 + (s2 + t2)/u2) - 8./27.*s2/(u*t);
+         break;
+      case qqBarProcess:
+         // qq\bar -> q'q\bar' for all other active flavours, qq\bar -> qq\bar, and qq\bar -> gg
+         matrixElement2 = 2.*(numberOfActiveFlavours - 1)*4./9.*(t2 + u2)/s2 + 
+                          4./9.*((s2 + u2)/t2 + (s2 + t2)/u2 + 2.*(t2 + u2)/s2) - 
+                          8./27.*(u2/(s*t) + t2/(s*u)) + 
+                          32./27.*(t2 + u2)/(t*u) - 8./3.*(t2 + u2)/s2;
+         break;
+      case qgProcess:
+         // qg -> qg and qg -> gq
+         matrixElement2 = -4./9.*((s2 + u2)/(s*u) + (s2 + t2)/(s*t)) + 
+                          (s2 + u2)/t2 + (s2 + t2)/u2;
+         break;
+      case ggProcess:
+         // gg -> qq\bar for all active flavours and gg -> gg
+         matrixElement2 = 2.*numberOfActiveFlavours*(1./6.*(t2 + u2)/(t*u) - 3./8.*(t2 + u2)/s2) + 
+                          9./2.*(3. - t*u/s2 - s*u/t2 - s*t/u2);
+         break;
+   }
+   // d\sigma / d\Omega = |M|^2/(64 \pi^2 s) where g^4 = 16 \pi^2 \alpha_S^2
+   return alphaS*alphaS/(4.*s)*matrixElement2;
 }
 
 double GetDSigmaDPTDY1DY2(const double pT, const double s, 
                           const double y1, const double y2, 
                           const double x1, const double x2)
 {
-   // result of a sum over all combinations
-   double result = 0.;
-   
-   // iterating over all posible combinations
-   for (int id1 = -5; id1 <= 5; id1++)
+   // parton densities x*f(x, \mu_F^2) of all flavours for both partons; every value 
+   // is reused for all combinations below instead of being interpolated for each of them;
+   // vectors are thread local so that they are not reallocated for every integration step
+   thread_local std::vector<double> xfx1(numberOfPDFFlavours), xfx2(numberOfPDFFlavours);
+   GetPartonDensities(x1, pT*pT, xfx1);
+   GetPartonDensities(x2, pT*pT, xfx2);
+
+   // parton luminosities summed over all ordered pairs of incoming partons of every class;
+   // since the table is known during compilation the loop has no branches
+   double luminosity[numberOfProcessClasses] = {};
+   for (int i = 0; i < numberOfActivePartons; i++)
    {
-      for (int id2 = id1; id2 <= 5; id2++)
+      // index in LHAPDF vectors is id + 6 while index in the table is id + numberOfActiveFlavours
+      const double xfx1i = xfx1[i - numberOfActiveFlavours + 6];
+      for (int j = 0; j < numberOfActivePartons; j++)
       {
-         // to do : determine measurement units for the following expression
-         result += 8.*M_PI*pT*pdf->xfxQ2(((id1 == 0) ? 21 : id1), x1, pT*pT)*
-                   pdf->xfxQ2(((id2 == 0) ? 21 : id2), x2, pT*pT)*
-                   GetDSigmaDOmega(id1, id2, pT, s, y1 - y2)/s;
-         // to do: add an expression to calculate result for non-identical particles
+         luminosity[processClassTable[i][j]] += xfx1i*xfx2[j - numberOfActiveFlavours + 6];
       }
    }
-   return result;
+
+   // mandelstam variables in the parton COM frame where cos(\Theta) = tanh((y1 - y2)/2)
+   const double cosTheta = tanh((y1 - y2)/2.);
+   const double t = -s/2.*(1. - cosTheta);
+   const double u = -s/2.*(1. + cosTheta);
+
+   // obtaining alpha_{S} at hard scale, i.e. \mu_F = p_T; it is the same for all processes
+   const double alphaS = GetAlphaS(pT*pT);
+
+   // every class of processes is calculated once and weighted by its luminosity
+   double result = 0.;
+   for (int processClass = 0; processClass < numberOfProcessClasses; processClass++)
+   {
+      if (luminosity[processClass] == 0.) continue;
+      result += luminosity[processClass]*GetDSigmaDOmega(processClass, alphaS, s, t, u);
+   }
+
+   // factor common for all combinations
+   // to do : determine measurement units for the following expression
+   return 8.*M_PI*pT*result/s;
+}
+
+void GetPartonDensities(const double x, const double Q2, std::vector<double>& xfx)
+{
+   if (pdfGrid) 
+   {
+      pdfGrid->xfxQ2(x, Q2, xfx);
+      return;
+   }
+   // LHAPDF fills values for ids from -6 to 6 in one call where 
+   // the gluon (id 21) is placed at the position of id 0
+   pdf->xfxQ2(x, Q2, xfx);
+}
+
+double GetAlphaS(const double Q2)
+{
+   if (pdfGrid) return pdfGrid->alphasQ2(Q2);
+   return pdf->alphasQ2(Q2);
 }
 
 double GetX1(const double pT, const double sqrtSNN, const double y1, const double y2)
@@ -123,112 +1025,398 @@ double GetX1(const double pT, const double sqrtSNN, const double y1, const doubl
 
 double GetX2(const double pT, const double sqrtSNN, const double y1, const double y2)
 {
-   // To do: fill in the formula for x2 in the current function
-   return 0.5;
+   return 2.*pT/sqrtSNN*exp(-(y1 + y2)/2.)*cosh((y1 - y2)/2.);
 }
 
-double GetDSigmaDPT(const double pT, const double sqrtSNN, const double absYMax, double &err)
+double GetDSigmaDPTDY1DY2(const double pT, const double sqrtSNN, const double y1, const double y2)
 {
-   // result of MC integration
-   double result = 0.;
-   // normalization constant for MC integration: equals to the number of succesfull integration steps
-   long normalization = 0;
+   // calculating x1 and x2
+   const double x1 = GetX1(pT, sqrtSNN, y1, y2);
+   const double x2 = GetX2(pT, sqrtSNN, y1, y2);
 
-   for (long i = 0; i < numberOfIntegrationSteps; i++)
+   // partons cannot carry more momentum than the nucleons
+   if (x1 >= 1. || x2 >= 1.) return 0.;
+
+   // calculating \sqrt{\hat{s}}, i.e. the center of mass energy of 2 partons
+   const double s = sqrtSNN*sqrtSNN*x1*x2;
+
+   return GetDSigmaDPTDY1DY2(pT, s, y1, y2, x1, x2);
+}
+
+int GetDSigmaDPTDY1DY2Block(const double *pT, const double *y1, const double *y2, 
+                            const double sqrtSNN, double *result, const int n)
+{
+   // intermediate arrays are thread local so that they are allocated only once
+   thread_local PhaseSpaceBlock block;
+
+   // kinematics: x1, x2, \hat{s}, \hat{t}, \hat{u}, and the mask of kinematically allowed points
+   int numberOfAllowedPoints = 0;
+   for (int k = 0; k < n; k++)
    {
-      // randomly choosing y1 and y2
-      const double y1 = rnd.Uniform(-absYMax, absYMax);
-      const double y2 = rnd.Uniform(-absYMax, absYMax);
+      const double halfSum = (y1[k] + y2[k])/2.;
+      const double halfDifference = (y1[k] - y2[k])/2.;
+      const double xFactor = 2.*pT[k]/sqrtSNN*cosh(halfDifference);
+      const double x1 = xFactor*exp(halfSum);
+      const double x2 = xFactor*exp(-halfSum);
 
-      // calculating x1 and x2
-      const double x1 = GetX1(pT, sqrtSNN, y1, y2);
-      const double x2 = GetX2(pT, sqrtSNN, y1, y2);
+      const bool isAllowed = (x1 < 1.) && (x2 < 1.);
+      block.mask[k] = isAllowed ? 1. : 0.;
+      numberOfAllowedPoints += isAllowed;
 
-      // to do: add a check that tests whether x1 and x2 are within kinematicaly possible range
+      // forbidden points get x = 0.5 so that the pdf is never evaluated outside of its range
+      block.x1[k] = isAllowed ? x1 : 0.5;
+      block.x2[k] = isAllowed ? x2 : 0.5;
+      block.Q2[k] = pT[k]*pT[k];
 
-      // calculating \sqrt{\hat{s}}, i.e. the center of mass energy of 2 partons
-      const double s = sqrtSNN*sqrtSNN*x1*x2;
+      block.s[k] = sqrtSNN*sqrtSNN*block.x1[k]*block.x2[k];
+      const double cosTheta = tanh(halfDifference);
+      block.t[k] = -block.s[k]/2.*(1. - cosTheta);
+      block.u[k] = -block.s[k]/2.*(1. + cosTheta);
+   }
 
-      // only do the following calculations after all cuts
-      result += GetDSigmaDPTDY1DY2(pT, s, y1, y2, x1, x2);
-      // normalization constant is a sum of weights; for uniform distribution all weights are 1
-      normalization++;
+   // \alpha_S and parton densities; the grid backend evaluates every flavour for 
+   // all points at once while LHAPDF is called once per point for all flavours
+   if (pdfGrid)
+   {
+      pdfGrid->alphasQ2(block.Q2, block.alphaS, n);
+      for (int i = 0; i < numberOfActivePartons; i++)
+      {
+         const int id = i - numberOfActiveFlavours;
+         pdfGrid->xfx(id, block.x1, block.Q2, block.xfx1[i], n);
+         pdfGrid->xfx(id, block.x2, block.Q2, block.xfx2[i], n);
+      }
+   }
+   else
+   {
+      thread_local std::vector<double> xfx1(numberOfPDFFlavours), xfx2(numberOfPDFFlavours);
+      for (int k = 0; k < n; k++)
+      {
+         block.alphaS[k] = pdf->alphasQ2(block.Q2[k]);
+         pdf->xfxQ2(block.x1[k], block.Q2[k], xfx1);
+         pdf->xfxQ2(block.x2[k], block.Q2[k], xfx2);
+         for (int i = 0; i < numberOfActivePartons; i++)
+         {
+            block.xfx1[i][k] = xfx1[i - numberOfActiveFlavours + 6];
+            block.xfx2[i][k] = xfx2[i - numberOfActiveFlavours + 6];
+         }
+      }
    }
 
-   if (normalization == 0) 
+   // parton luminosities of every class of processes; the innermost loop goes over points
+   for (int processClass = 0; processClass < numberOfProcessClasses; processClass++)
    {
-      err = 0.;
-      return 0.;
+      std::fill(block.luminosity[processClass], block.luminosity[processClass] + n, 0.);
+   }
+   for (int i = 0; i < numberOfActivePartons; i++)
+   {
+      for (int j = 0; j < numberOfActivePartons; j++)
+      {
+         double *luminosity = block.luminosity[processClassTable[i][j]];
+         const double *xfx1 = block.xfx1[i];
+         const double *xfx2 = block.xfx2[j];
+         for (int k = 0; k < n; k++) luminosity[k] += xfx1[k]*xfx2[k];
+      }
    }
 
-   // without multiplying the result by area we just get average value; 
-   // area is needed to obtain from that average value an integral
-   // normalization/numberOfIntegrationSteps is needed since not all points
-   // correspond to the kinematicaly allowed area, but those that do were selected
-   // and counted by the normalization constant
-   const double area = 4*absYMax*absYMax*static_cast<double>(normalization)/
-                       static_cast<double>(numberOfIntegrationSteps);
+   // all classes of processes are summed in one loop without branches; 
+   // class arguments are constants so that the switch is resolved during compilation
+   for (int k = 0; k < n; k++)
+   {
+      const double s = block.s[k], t = block.t[k], u = block.u[k], alphaS = block.alphaS[k];
+      const double dSigmaDOmega = 
+         block.luminosity[qqPrimeProcess][k]*GetDSigmaDOmega(qqPrimeProcess, alphaS, s, t, u) + 
+         block.luminosity[qqProcess][k]*GetDSigmaDOmega(qqProcess, alphaS, s, t, u) + 
+         block.luminosity[qqBarProcess][k]*GetDSigmaDOmega(qqBarProcess, alphaS, s, t, u) + 
+         block.luminosity[qgProcess][k]*GetDSigmaDOmega(qgProcess, alphaS, s, t, u) + 
+         block.luminosity[ggProcess][k]*GetDSigmaDOmega(ggProcess, alphaS, s, t, u);
+      result[k] = block.mask[k]*8.*M_PI*pT[k]*dSigmaDOmega/s;
+   }
 
-   // scaling integration sum by the number of succesfull 
-   // integration steps and by the integration area
-   result *= area/static_cast<double>(normalization);
+   return numberOfAllowedPoints;
+}
 
-   // 2 is present since area and MC integration statistical uncertainty 
-   // produce the same uncertainty which has to be propagated between them
-   err = result/sqrt(normalization/2.);
+void GetDSigmaDPTDY1DY2Block(const double pT, const double *y, const double sqrtSNN, 
+                             double *values, const int n)
+{
+   thread_local double pTs[integrationBlockSize];
+   std::fill(pTs, pTs + n, pT);
+   GetDSigmaDPTDY1DY2Block(pTs, y, y + integrationBlockSize, sqrtSNN, values, n);
+}
 
-   return result;
+void GetDSigmaDDeltaYBlock(const double deltaY, const double *points, const double sqrtSNN, 
+                           const double absYMax, double *values, const int n)
+{
+   thread_local double y2s[integrationBlockSize];
+   const double *y1s = points + integrationBlockSize;
+   for (int k = 0; k < n; k++) y2s[k] = y1s[k] - deltaY;
+
+   GetDSigmaDPTDY1DY2Block(points, y1s, y2s, sqrtSNN, values, n);
+
+   // y2 is outside of the rapidity range
+   for (int k = 0; k < n; k++) values[k] *= (fabs(y2s[k]) <= absYMax) ? 1. : 0.;
 }
 
-double GetDSigmaDDeltaY(const double deltaY, const double sqrtSNN, const double absYMax, const double pTHatMin, double &err)
+double GetDSigmaDPT(const double pT, const double sqrtSNN, const double absYMax, double &err)
 {
-   // This is just a functiont prototype The intended purpose of which is to show how to 
-   // randomly choose pT. If the pT is chosen from the uniform distribution the cross section
-   // values will jump to much from point to point due to significant contribution coming from
-   // low pT region (with finite integration calculation steps only few points on this range will be
-   // selected which results in some points having larger contribution from low pT that the other
-   // thus the "jumpiness" of a histogram points arises). 
+   if (integrationMethod == "vegas")
+   {
+      // y1 and y2 are distributed by the adaptive grid instead of uniformly
+      const double lower[2] = {-absYMax, -absYMax};
+      const double upper[2] = {absYMax, absYMax};
+      return IntegrateVegas(2, lower, upper, [&](const double *y, double *values, const int n) 
+                            {GetDSigmaDPTDY1DY2Block(pT, y, sqrtSNN, values, n);}, err);
+   }
+   if (integrationMethod == "qmc")
+   {
+      // y1 and y2 are taken from scrambled Sobol sequences instead of TRandom
+      const double lower[2] = {-absYMax, -absYMax};
+      const double upper[2] = {absYMax, absYMax};
+      return IntegrateQMC(2, lower, upper, [&](const double *y, double *values, const int n) 
+                          {GetDSigmaDPTDY1DY2Block(pT, y, sqrtSNN, values, n);}, err);
+   }
 
-   double normalization = 0.;
-   double result = 0.;
+   // area of the integration; kinematically forbidden points give 0 so the integral
+   // is the average value over all points multiplied by the area
+   const double area = 4.*absYMax*absYMax;
+
+   // sum of values of all points multiplied by the area and sum of their squares
+   double sum = 0., sum2 = 0.;
 
-   for (long i = 0; i < numberOfIntegrationSteps; i++)
+   // points are generated and evaluated in blocks
+   thread_local double pTs[integrationBlockSize], y1s[integrationBlockSize], 
+                       y2s[integrationBlockSize], values[integrationBlockSize];
+   std::fill(pTs, pTs + integrationBlockSize, pT);
+
+   for (long i = 0; i < numberOfIntegrationSteps; i += integrationBlockSize)
    {
-      // To do : add correct formula for tau
-      // This is one way to achieve this: to distrubute pT in a way so that 
-      // there are many more points on low pT
-      const double tau = 1.;
-      const double pT = pTHatMin + rnd.Exp(tau);
-      // In order for the TRandom to work correctly and fast tau needs to be defined so that
-      // \int_{pTHatMIn}^{pTMax} e^{-x/tau) dx = 1
-      // Where pTMax - maximum kinematicaly possible pT value
-      // Exponent is chosen since it resembles the form of d\Sigma/dpT. The closer the resemblance - 
-      // the better error estimation is performed for finite number of integration steps
+      const int n = static_cast<int>(std::min(static_cast<long>(integrationBlockSize), 
+                                              numberOfIntegrationSteps - i));
+      for (int k = 0; k < n; k++)
+      {
+         // randomly choosing y1 and y2
+         y1s[k] = rnd.Uniform(-absYMax, absYMax);
+         y2s[k] = rnd.Uniform(-absYMax, absYMax);
+      }
 
-      // But since the distribution is non-uniform the normalization 
-      // needs to be explicitly calculated as sum of weights
-      normalization += exp(-(pT - pTHatMin)/tau); // here exp(-pT/tau) is weight
+      GetDSigmaDPTDY1DY2Block(pTs, y1s, y2s, sqrtSNN, values, n);
+      for (int k = 0; k < n; k++)
+      {
+         const double value = values[k]*area;
+         sum += value;
+         sum2 += value*value;
+      }
+   }
 
-      // dummy value
-      result += 1e-6;
+   // uncertainty is the standard error of the mean so that it reflects 
+   // the variance of the integrand and not only the number of points
+   return GetMeanAndError(sum, sum2, numberOfIntegrationSteps, err);
+}
+
+double GetDSigmaDDeltaY(const double deltaY, const double sqrtSNN, const double absYMax, 
+                        const double pTHatMin, double &err)
+{
+   if (integrationMethod == "vegas")
+   {
+      // integration is performed over pT and y1 while y2 is fixed by \Delta y; the adaptive 
+      // grid concentrates pT points at low pT instead of the exponential distribution below
+      const double lower[2] = {pTHatMin, -absYMax};
+      const double upper[2] = {sqrtSNN/2., absYMax};
+      return IntegrateVegas(2, lower, upper, [&](const double *points, double *values, const int n)
+                            {GetDSigmaDDeltaYBlock(deltaY, points, sqrtSNN, absYMax, values, n);}, 
+                            err);
+   }
+   if (integrationMethod == "qmc")
+   {
+      // same integration variables as for VEGAS but taken from scrambled Sobol sequences
+      const double lower[2] = {pTHatMin, -absYMax};
+      const double upper[2] = {sqrtSNN/2., absYMax};
+      return IntegrateQMC(2, lower, upper, [&](const double *points, double *values, const int n)
+                          {GetDSigmaDDeltaYBlock(deltaY, points, sqrtSNN, absYMax, values, n);}, 
+                          err);
    }
-   // To do: add normalization by integration volume
 
-   // To do: check for other sources of uncertainties and propagate 
-   // them with this error if you find any
-   err = result/sqrt(normalization);
+   // pT is sampled from pTHatMin to the kinematic limit as in "events" mode so that most points
+   // are at low pT where d\sigma / dp_T dy_1 dy_2 is the largest; y1 is sampled uniformly and
+   // y2 is fixed by \Delta y
+   const double pTMax = sqrtSNN/2.;
+   const double areaY = 2.*absYMax;
 
-   return result/normalization;
+   // sum of weighted values of all points and sum of their squares
+   double sum = 0., sum2 = 0.;
+
+   // pT and y1 of a block are placed in the same way as for VEGAS and QMC
+   thread_local double points[2*integrationBlockSize], jacobians[integrationBlockSize], 
+                       values[integrationBlockSize];
+
+   for (long i = 0; i < numberOfIntegrationSteps; i += integrationBlockSize)
+   {
+      const int n = static_cast<int>(std::min(static_cast<long>(integrationBlockSize), 
+                                              numberOfIntegrationSteps - i));
+      for (int k = 0; k < n; k++)
+      {
+         points[k] = SamplePowerLaw(rnd.Rndm(), pTHatMin, pTMax, pTSamplingPower, jacobians[k]);
+         points[integrationBlockSize + k] = rnd.Uniform(-absYMax, absYMax);
+      }
+
+      // kinematically forbidden points and points with |y2| > absYMax give 0
+      GetDSigmaDDeltaYBlock(deltaY, points, sqrtSNN, absYMax, values, n);
+      for (int k = 0; k < n; k++)
+      {
+         const double value = values[k]*jacobians[k]*areaY;
+         sum += value;
+         sum2 += value*value;
+      }
+   }
+
+   return GetMeanAndError(sum, sum2, numberOfIntegrationSteps, err);
+}
+
+double GetMeanAndError(const double sum, const double sum2, const long n, double &err)
+{
+   if (n < 2)
+   {
+      err = 0.;
+      return (n == 1) ? sum : 0.;
+   }
+   const double mean = sum/static_cast<double>(n);
+   // variance of the mean is the sample variance divided by the number of points
+   const double variance = std::max(sum2/static_cast<double>(n) - mean*mean, 0.)/
+                           static_cast<double>(n - 1);
+   err = sqrt(variance);
+   return mean;
 }
 
 
-unsigned int GetRandomSeed()
+template<typename Integrand>
+double IntegrateVegas(const int dimension, const double *lower, const double *upper, 
+                      Integrand integrand, double &err)
+{
+   VegasGrid grid(dimension, numberOfVegasBins);
+
+   // coordinate d of point k of a block is placed at d*integrationBlockSize + k
+   std::vector<double> u(dimension), point(dimension), points(dimension*integrationBlockSize);
+   std::vector<double> jacobians(integrationBlockSize), values(integrationBlockSize);
+   std::vector<int> bins(dimension*integrationBlockSize);
+
+   double volume = 1.;
+   for (int d = 0; d < dimension; d++) volume *= upper[d] - lower[d];
+
+   // integration steps are split equally between iterations
+   const int nIterations = std::max(numberOfVegasIterations, 1);
+   const long nSteps = std::max(numberOfIntegrationSteps/nIterations, 2L);
+
+   // results of iterations are combined with weights inversely proportional to their variances
+   double weightedSum = 0., sumOfWeights = 0., lastMean = 0.;
+
+   for (int iteration = 0; iteration < nIterations; iteration++)
+   {
+      double sum = 0., sum2 = 0.;
+      for (long i = 0; i < nSteps; i += integrationBlockSize)
+      {
+         const int n = static_cast<int>(std::min(static_cast<long>(integrationBlockSize), 
+                                                 nSteps - i));
+         for (int k = 0; k < n; k++)
+         {
+            for (int d = 0; d < dimension; d++) u[d] = rnd.Rndm();
+
+            jacobians[k] = grid.Map(u.data(), point.data(), bins.data() + k*dimension);
+            for (int d = 0; d < dimension; d++) 
+            {
+               points[d*integrationBlockSize + k] = lower[d] + point[d]*(upper[d] - lower[d]);
+            }
+         }
+
+         integrand(points.data(), values.data(), n);
+
+         for (int k = 0; k < n; k++)
+         {
+            const double value = values[k]*jacobians[k];
+            sum += value;
+            sum2 += value*value;
+            grid.Accumulate(bins.data() + k*dimension, value*value);
+         }
+      }
+      grid.Refine();
+
+      lastMean = sum/static_cast<double>(nSteps);
+      const double variance = (sum2/static_cast<double>(nSteps) - lastMean*lastMean)/
+                              static_cast<double>(nSteps - 1);
+
+      // the first iteration is performed on the uniform grid and is only used for the adaptation
+      if (iteration == 0 && nIterations > 1) continue;
+      if (variance <= 0.) continue;
+
+      weightedSum += lastMean/variance;
+      sumOfWeights += 1./variance;
+   }
+
+   // integrand was constant (or 0) in all points
+   if (sumOfWeights == 0.)
+   {
+      err = 0.;
+      return lastMean*volume;
+   }
+
+   err = volume/sqrt(sumOfWeights);
+   return volume*weightedSum/sumOfWeights;
+}
+
+template<typename Integrand>
+double IntegrateQMC(const int dimension, const double *lower, const double *upper, 
+                    Integrand integrand, double &err)
 {
-	auto now = std::chrono::high_resolution_clock::now();
-	auto now_ms = std::chrono::time_point_cast<std::chrono::milliseconds>(now);
-	auto epoch = now_ms.time_since_epoch();
-	auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(epoch);
-	return static_cast<unsigned int>(duration.count() % 900000000);
+   // coordinate d of point k of a block is placed at d*integrationBlockSize + k
+   std::vector<double> point(dimension), points(dimension*integrationBlockSize);
+   std::vector<double> values(integrationBlockSize);
+
+   double volume = 1.;
+   for (int d = 0; d < dimension; d++) volume *= upper[d] - lower[d];
+
+   // integration steps are split equally between replicas; at least 2 replicas 
+   // are needed to estimate the uncertainty
+   const int nReplicas = std::max(numberOfQMCReplicas, 2);
+   const long nSteps = std::max(numberOfIntegrationSteps/nReplicas, 1L);
+
+   // sum of replica results and sum of their squares
+   double sum = 0., sum2 = 0.;
+
+   for (int replica = 0; replica < nReplicas; replica++)
+   {
+      // scrambling is derived from rnd so that it depends on the seed of the bin
+      const uint64_t scrambleSeed = (static_cast<uint64_t>(rnd.Rndm()*4294967296.) << 32) ^ 
+                                    static_cast<uint64_t>(rnd.Rndm()*4294967296.);
+      SobolSequence sequence(dimension, scrambleSeed);
+
+      double replicaSum = 0.;
+      for (long i = 0; i < nSteps; i += integrationBlockSize)
+      {
+         const int n = static_cast<int>(std::min(static_cast<long>(integrationBlockSize), 
+                                                 nSteps - i));
+         for (int k = 0; k < n; k++)
+         {
+            sequence.Next(point.data());
+            for (int d = 0; d < dimension; d++) 
+            {
+               points[d*integrationBlockSize + k] = lower[d] + point[d]*(upper[d] - lower[d]);
+            }
+         }
+
+         integrand(points.data(), values.data(), n);
+         for (int k = 0; k < n; k++) replicaSum += values[k];
+      }
+
+      const double replicaResult = volume*replicaSum/static_cast<double>(nSteps);
+      sum += replicaResult;
+      sum2 += replicaResult*replicaResult;
+   }
+
+   // replicas are independent estimates so the uncertainty of 
+   // their average is obtained from their spread
+   const double mean = sum/static_cast<double>(nReplicas);
+   const double variance = std::max(sum2/static_cast<double>(nReplicas) - mean*mean, 0.)/
+                           static_cast<double>(nReplicas - 1);
+   err = sqrt(variance);
+   return mean;
 }
 
 #endif /* CALCULATE_ANALYTIC_CPP */
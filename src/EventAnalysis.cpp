@@ -0,0 +1,219 @@
+/**
+ *  @file   EventAnalysis.cpp
+ *  @brief  Contains implementations of settings, histograms, and jet reconstruction that are shared by executables that analyze PYTHIA8 events
+ *
+ *  This file is a part of a project HadronProcessesLO (https://github.com/Sergeyir/HadronProcessesLO).
+ *
+ *  @author Sergei Antsupov (antsupov0124@gmail.com)
+ **/
+#ifndef EVENT_ANALYSIS_CPP
+#define EVENT_ANALYSIS_CPP
+
+#include "EventAnalysis.hpp"
+
+void StoredEvent::CreateBranches(TTree *tree)
+{
+   tree->Branch("weight", &weight);
+   tree->Branch("px", &px);
+   tree->Branch("py", &py);
+   tree->Branch("pz", &pz);
+   tree->Branch("e", &e);
+   tree->Branch("partonPx", &partonPx);
+   tree->Branch("partonPy", &partonPy);
+   tree->Branch("partonPz", &partonPz);
+   tree->Branch("partonE", &partonE);
+   tree->Branch("partonId", &partonId);
+}
+
+void StoredEvent::SetBranchAddresses(TTree *tree)
+{
+   // ROOT needs addresses of pointers to vectors to read them
+   pxAddress = &px;
+   pyAddress = &py;
+   pzAddress = &pz;
+   eAddress = &e;
+   partonPxAddress = &partonPx;
+   partonPyAddress = &partonPy;
+   partonPzAddress = &partonPz;
+   partonEAddress = &partonE;
+   partonIdAddress = &partonId;
+
+   tree->SetBranchAddress("weight", &weight);
+   tree->SetBranchAddress("px", &pxAddress);
+   tree->SetBranchAddress("py", &pyAddress);
+   tree->SetBranchAddress("pz", &pzAddress);
+   tree->SetBranchAddress("e", &eAddress);
+   tree->SetBranchAddress("partonPx", &partonPxAddress);
+   tree->SetBranchAddress("partonPy", &partonPyAddress);
+   tree->SetBranchAddress("partonPz", &partonPzAddress);
+   tree->SetBranchAddress("partonE", &partonEAddress);
+   tree->SetBranchAddress("partonId", &partonIdAddress);
+}
+
+void StoredEvent::Clear()
+{
+   px.clear();
+   py.clear();
+   pz.clear();
+   e.clear();
+   partonPx.clear();
+   partonPy.clear();
+   partonPz.clear();
+   partonE.clear();
+   partonId.clear();
+}
+
+bool ReadGeneratorSettings(const YAML::Node& inputFileContents, GeneratorSettings& settings)
+{
+   // lower we can use YAML::Node object data via array index operator[]
+   settings.pdfSet = inputFileContents["pdfset"].as<std::string>();
+   // hard process lower bound on pT [GeV/c]
+   settings.pTHatMin = inputFileContents["pthatmin"].as<double>();
+   // collision energy [GeV] in a center of mass frame;
+   settings.energyCM = inputFileContents["energy"].as<double>();
+
+   // pT-hat bias spreads generated events evenly across the pT spectrum instead of 
+   // concentrating them near pthatmin; histograms stay correct since events are weighted
+   settings.pTHatBiasPower = inputFileContents["pthat_bias_power"] ? 
+                             inputFileContents["pthat_bias_power"].as<double>() : 0.;
+   settings.pTHatBiasReference = inputFileContents["pthat_bias_reference"] ? 
+                                 inputFileContents["pthat_bias_reference"].as<double>() : 
+                                 settings.pTHatMin;
+   if (settings.pTHatBiasPower < 0. || settings.pTHatBiasReference <= 0.)
+   {
+      std::cout << "\033[1m\033[31mError:\033[0m pthat_bias_power must not be negative and "\
+                   "pthat_bias_reference must be positive" << std::endl;
+      return false;
+   }
+
+   settings.jetDefinitions.clear();
+   settings.jetNames.clear();
+
+   // "full" generates complete events; "parton" only generates hard processes which is enough 
+   // for the distribution of hard process partons and is much faster
+   const std::string mode = inputFileContents["mode"] ? 
+                            inputFileContents["mode"].as<std::string>() : "full";
+   if (mode == "parton")
+   {
+      // there are no final state particles from which jets can be reconstructed
+      settings.partonLevel = true;
+      return true;
+   }
+   else if (mode != "full")
+   {
+      std::cout << "\033[1m\033[31mError:\033[0m unknown mode " << mode << 
+                   "; expected full or parton" << std::endl;
+      return false;
+   }
+   settings.partonLevel = false;
+
+   // without the list of jets only anti-kt jets with R parameter fastjet_r are reconstructed
+   if (!inputFileContents["jets"])
+   {
+      settings.jetDefinitions.emplace_back(fastjet::antikt_algorithm, 
+                                           inputFileContents["fastjet_r"].as<double>());
+      settings.jetNames.push_back("");
+      return true;
+   }
+
+   for (const YAML::Node& entry : inputFileContents["jets"])
+   {
+      const std::string algorithmName = entry["algorithm"] ? 
+                                        entry["algorithm"].as<std::string>() : "antikt";
+      if (!entry["r"])
+      {
+         std::cout << "\033[1m\033[31mError:\033[0m R parameter r is not set for jets " << 
+                      algorithmName << std::endl;
+         return false;
+      }
+      const double r = entry["r"].as<double>();
+
+      fastjet::JetAlgorithm algorithm;
+      if (algorithmName == "antikt") algorithm = fastjet::antikt_algorithm;
+      else if (algorithmName == "kt") algorithm = fastjet::kt_algorithm;
+      else if (algorithmName == "cambridge") algorithm = fastjet::cambridge_algorithm;
+      else
+      {
+         std::cout << "\033[1m\033[31mError:\033[0m unknown jet algorithm " << algorithmName << 
+                      "; expected antikt, kt, or cambridge" << std::endl;
+         return false;
+      }
+
+      // Best lets fastjet choose the fastest strategy for the number of particles in an event
+      const std::string strategyName = entry["strategy"] ? 
+                                       entry["strategy"].as<std::string>() : "Best";
+      fastjet::Strategy strategy;
+      if (strategyName == "Best") strategy = fastjet::Best;
+      else if (strategyName == "N2Tiled") strategy = fastjet::N2Tiled;
+      else if (strategyName == "N2MinHeapTiled") strategy = fastjet::N2MinHeapTiled;
+      else if (strategyName == "N2PoorTiled") strategy = fastjet::N2PoorTiled;
+      else if (strategyName == "N2Plain") strategy = fastjet::N2Plain;
+      else if (strategyName == "NlnN") strategy = fastjet::NlnN;
+      else
+      {
+         std::cout << "\033[1m\033[31mError:\033[0m unknown fastjet strategy " << strategyName << 
+                      "; expected Best, N2Tiled, N2MinHeapTiled, N2PoorTiled, N2Plain, or NlnN" << 
+                      std::endl;
+         return false;
+      }
+
+      if (r <= 0.)
+      {
+         std::cout << "\033[1m\033[31mError:\033[0m R parameter of jets must be positive" << 
+                      std::endl;
+         return false;
+      }
+
+      settings.jetDefinitions.emplace_back(algorithm, r, strategy);
+
+      // default name is made from the algorithm, R, and the strategy if it is not Best, 
+      // e.g. antikt_R0.4 or antikt_R0.4_N2Tiled
+      std::ostringstream name;
+      if (entry["name"]) name << entry["name"].as<std::string>();
+      else
+      {
+         name << algorithmName << "_R" << r;
+         if (strategy != fastjet::Best) name << "_" << strategyName;
+      }
+
+      // histograms of jets are written under their names so the names must be unique
+      if (std::find(settings.jetNames.begin(), settings.jetNames.end(), name.str()) != 
+          settings.jetNames.end())
+      {
+         std::cout << "\033[1m\033[31mError:\033[0m jets " << name.str() << 
+                      " are defined more than once; set unique names for them" << std::endl;
+         return false;
+      }
+      settings.jetNames.push_back(name.str());
+   }
+
+   if (settings.jetDefinitions.empty())
+   {
+      std::cout << "\033[1m\033[31mError:\033[0m list of jets is empty" << std::endl;
+      return false;
+   }
+   return true;
+}
+
+void FillJets(const std::vector<fastjet::PseudoJet>& particles,
+              const std::vector<fastjet::JetDefinition>& jetDefinitions, const double pTMin,
+              const double eventWeight, GeneratorOutput& output)
+{
+   // all jet definitions are run over the same particles
+   for (unsigned int i = 0; i < jetDefinitions.size(); i++)
+   {
+      // running jet clustering algorithm
+      fastjet::ClusterSequence clusterSeq(particles, jetDefinitions[i]);
+      // vector filled with jets reconstructed from vector particles
+      std::vector<fastjet::PseudoJet> inclusiveJets = clusterSeq.inclusive_jets(pTMin);
+
+      // iterating over reconstructed jets
+      for (unsigned int j = 0; j < inclusiveJets.size(); j++)
+      {
+         // To do : add a check that tests whether jets are within the needed rapidity range
+         output.distrJetsPT[i].Fill(inclusiveJets[j].pt(), eventWeight);
+      }
+   }
+}
+
+#endif /* EVENT_ANALYSIS_CPP */
@@ -14,12 +14,14 @@
 int main(int argc, char **argv)
 {
    // printing info on usage and exiting program if number of parameters is incorrect
-   if (argc != 3) 
+   if (argc < 3)
    {
-      std::cout << "\033[1m\033[31mError:\033[0m Expected 2 parameters while " <<
+      std::cout << "\033[1m\033[31mError:\033[0m Expected at least 2 parameters while " <<
                    std::to_string(argc - 1) << " parameter(s) were provided \n"\
-                   "Usage: bin/GenerateData inputFileName.yaml numberOfEvents" << std::endl;
-      std::cout << "[\033[1m\033[32mINFO\033[0m] " << 
+                   "Usage: bin/GenerateData inputFileName.yaml numberOfEvents "\
+                   "[--threads N] [--clustering-threads M] [--seed S] [--shard I --shards N] "\
+                   "[--store-events] [--checkpoint T] [--resume]" << std::endl;
+      std::cout << "[\033[1m\033[32mINFO\033[0m] " <<
                    " input file example is located in input directory" << std::endl;
       return 1;
    }
@@ -31,73 +33,544 @@ int main(int argc, char **argv)
       return 1;
    }
 
+   const long numberOfEvents = std::stol(argv[2]);
+   baseSeed = GetRandomSeed();
+
+   // reading optional parameters
+   for (int i = 3; i < argc; i++)
+   {
+      const std::string option = argv[i];
+      // options without values
+      if (option == "--store-events")
+      {
+         storeEvents = true;
+         continue;
+      }
+      if (option == "--resume")
+      {
+         resumeFromCheckpoint = true;
+         continue;
+      }
+      if (i + 1 >= argc)
+      {
+         std::cout << "\033[1m\033[31mError:\033[0m no value was provided for option " <<
+                      option << std::endl;
+         return 1;
+      }
+      if (option == "--threads") numberOfThreads = std::stoul(argv[++i]);
+      else if (option == "--clustering-threads") numberOfClusteringThreads = std::stoul(argv[++i]);
+      else if (option == "--seed") baseSeed = std::stoul(argv[++i]);
+      else if (option == "--shard") shardIndex = std::stoi(argv[++i]);
+      else if (option == "--shards") numberOfShards = std::stoi(argv[++i]);
+      else if (option == "--checkpoint") checkpointInterval = std::stod(argv[++i]);
+      else
+      {
+         std::cout << "\033[1m\033[31mError:\033[0m unknown option " << option << std::endl;
+         return 1;
+      }
+   }
+
+   if (numberOfShards < 1 || shardIndex < 0 || shardIndex >= numberOfShards)
+   {
+      std::cout << "\033[1m\033[31mError:\033[0m shard index " << shardIndex << 
+                   " is not in the range from 0 to the number of shards " << numberOfShards << 
+                   " - 1" << std::endl;
+      return 1;
+   }
+
+   // 0 threads means that all available cores will be used
+   if (numberOfThreads == 0) numberOfThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+   // events of other threads or of the event store may be lost or written twice
+   // if checkpoint of a thread is written while they are being processed
+   if ((checkpointInterval > 0. || resumeFromCheckpoint) && 
+       (storeEvents || numberOfClusteringThreads > 0))
+   {
+      std::cout << "\033[1m\033[31mError:\033[0m options --checkpoint and --resume can not be "\
+                   "used together with --store-events or --clustering-threads" << std::endl;
+      return 1;
+   }
+
+   // the resumed run must have the same seed and number of threads 
+   // since every thread continues the events of its checkpoint
+   std::string checkpointConfiguration;
+   if (resumeFromCheckpoint)
+   {
+      const std::string checkpointFileName = GetCheckpointFileName(0);
+      if (!std::filesystem::exists(checkpointFileName))
+      {
+         std::cout << "\033[1m\033[31mError:\033[0m checkpoint " << checkpointFileName << 
+                      " was not found" << std::endl;
+         return 1;
+      }
+
+      TFile checkpointFile(checkpointFileName.c_str(), "READ");
+      TParameter<Long64_t> *seedParameter, *threadsParameter, *nEventsParameter;
+      std::string *configurationParameter;
+      checkpointFile.GetObject("baseSeed", seedParameter);
+      checkpointFile.GetObject("numberOfThreads", threadsParameter);
+      checkpointFile.GetObject("nEvents", nEventsParameter);
+      checkpointFile.GetObject("configuration", configurationParameter);
+      if (!seedParameter || !threadsParameter || !nEventsParameter || !configurationParameter)
+      {
+         std::cout << "\033[1m\033[31mError:\033[0m file " << checkpointFileName << 
+                      " is not a checkpoint" << std::endl;
+         return 1;
+      }
+      baseSeed = static_cast<unsigned int>(seedParameter->GetVal());
+      numberOfThreads = static_cast<unsigned int>(threadsParameter->GetVal());
+      const long nEventsOfMainThread = nEventsParameter->GetVal();
+      checkpointConfiguration = *configurationParameter;
+      delete seedParameter;
+      delete threadsParameter;
+      delete nEventsParameter;
+      delete configurationParameter;
+      checkpointFile.Close();
+
+      if (nEventsOfMainThread != numberOfEvents/numberOfThreads + 
+                                 ((numberOfEvents % numberOfThreads > 0) ? 1 : 0))
+      {
+         std::cout << "\033[1m\033[31mError:\033[0m checkpoint was written by a run with "\
+                      "a different number of events" << std::endl;
+         return 1;
+      }
+      for (unsigned int i = 1; i < numberOfThreads; i++)
+      {
+         if (!std::filesystem::exists(GetCheckpointFileName(i)))
+         {
+            std::cout << "\033[1m\033[31mError:\033[0m checkpoint " << 
+                         GetCheckpointFileName(i) << " was not found" << std::endl;
+            return 1;
+         }
+      }
+      std::cout << "[\033[1m\033[32mINFO\033[0m] Resuming from checkpoints" << std::endl;
+   }
+
+   // all shards of one production use the same base seed and 
+   // every one of them gets its own seed derived from it
+   shardSeed = static_cast<unsigned int>(GetPythiaSeed(baseSeed, shardIndex));
+
+   // seed is printed so that the run can be reproduced with option --seed
+   // (the result also depends on the number of threads since every thread has its own seed)
+   std::cout << "[\033[1m\033[32mINFO\033[0m] Using seed " << baseSeed << " and " <<
+                numberOfThreads << " thread(s)";
+   if (numberOfShards > 1) 
+   {
+      std::cout << " for shard " << shardIndex << " of " << numberOfShards;
+   }
+   std::cout << std::endl;
+
    // YAML::Node object reads all data from the .yaml file
    YAML::Node inputFileContents = YAML::LoadFile(argv[1]);
 
+   // with "scan" node in the input file every configuration of the grid of parameters 
+   // is generated in this run and written to its own directory of the output file
+   std::vector<ScanConfiguration> configurations;
+   if (!ReadScanConfigurations(inputFileContents, configurations)) return 1;
+   const bool isScan = !configurations.front().name.empty();
+
+   // event store and checkpoints contain events of only one configuration
+   if (isScan && (storeEvents || checkpointInterval > 0. || resumeFromCheckpoint))
+   {
+      std::cout << "\033[1m\033[31mError:\033[0m options --store-events, --checkpoint, and "\
+                   "--resume are not supported for input files with scan" << std::endl;
+      return 1;
+   }
+
    // reading parameters from .yaml file
-   // lower we can use YAML::Node object data via array index operator[]
-   // hard process lower bound on pT [GeV/c]
-   const double pTHatMin = inputFileContents["pthatmin"].as<double>();
-   // collision energy [GeV] in a center of mass frame; 
-   const double energyCM = inputFileContents["energy"].as<double>();
+   std::vector<GeneratorSettings> settings(configurations.size());
+   for (std::size_t i = 0; i < configurations.size(); i++)
+   {
+      if (!ReadGeneratorSettings(configurations[i].inputFileContents, settings[i])) return 1;
+   }
 
-   // creating Pythia8:Pythia object
-   Pythia8::Pythia pythia;
+   // histograms of the checkpoint can only be continued with the same parameters 
+   // of the generation and the same jets
+   if (resumeFromCheckpoint && 
+       checkpointConfiguration != GetCheckpointConfiguration(settings.front()))
+   {
+      std::cout << "\033[1m\033[31mError:\033[0m checkpoint was written for "\
+                   "a different configuration: " << checkpointConfiguration << std::endl;
+      return 1;
+   }
+
+   // configurations that differ only in the analysis (e.g. in the lists of jets) are filled 
+   // from the same events so pythia is initialized once for every group of configurations 
+   // with the same parameters of the generation; every group is generated with the same seeds
+   // so the result of a configuration does not depend on the other configurations of a scan
+   std::vector<std::vector<std::size_t>> groups;
+   for (std::size_t i = 0; i < settings.size(); i++)
+   {
+      auto group = std::find_if(groups.begin(), groups.end(), 
+                                [&](const std::vector<std::size_t>& group) 
+                                {return HasSameGeneration(settings[group.front()], settings[i]);});
+      if (group == groups.end()) groups.push_back({i});
+      else group->push_back(i);
+   }
+
+   // ROOT needs to be notified that its objects will be used from multiple threads
+   ROOT::EnableThreadSafety();
+   // histograms of threads must not be attached to the current directory (file)
+   // since it is not thread safe; they are written explicitly at the end
+   TH1::AddDirectory(false);
+
+   // creating directory in which the output files will be written
+   std::filesystem::create_directory("output");
+
+   // every shard writes its own files so that the shards can be run in the same directory
+   const std::string shardSuffix = (numberOfShards > 1) ? 
+                                   "_shard" + std::to_string(shardIndex) : "";
+
+   // the files of all shards can be merged with bin/MergeData
+   const std::string outputFileName = "output/generated" + shardSuffix + ".root";
+   // file in which all histogram will be written; the following line will create
+   // (overwrite if exists) the file outputFileName and root will point to it
+   // so that TObject objects can be written in it by using method TObject::Write()
+   TFile outputFile(outputFileName.c_str(), "RECREATE");
+   // if another file is created after this with option "RECREATE", "UPDATE", or "CREATE"
+   // root will try to write TObject objects to the new defined file
+   // if you have multiple TFile files you write in in yor program use
+   // TFile::cd() to point root to the file you need
+
+   // event store is a TTree with one branch per quantity (columnar format) compressed with zstd;
+   // threads fill their own trees which are merged into one by TBufferMerger
+   const std::string eventsFileName = "output/events" + shardSuffix + ".root";
+   if (storeEvents)
+   {
+      eventsMerger = new ROOT::TBufferMerger(eventsFileName.c_str(), "RECREATE",
+         ROOT::CompressionSettings(ROOT::RCompressionSetting::EAlgorithm::kZSTD, 5));
+   }
+
+   for (const std::vector<std::size_t>& group : groups)
+   {
+      // jets of all configurations of the group are reconstructed from the same events;
+      // jet definitions shared by several configurations are reconstructed only once and 
+      // jetIndices[k][j] is the index of the j-th definition of the k-th configuration 
+      // in the definitions of the group
+      GeneratorSettings groupSettings = settings[group.front()];
+      groupSettings.jetDefinitions.clear();
+      groupSettings.jetNames.clear();
+      std::vector<std::vector<std::size_t>> jetIndices(group.size());
+      for (std::size_t k = 0; k < group.size(); k++)
+      {
+         const GeneratorSettings& configurationSettings = settings[group[k]];
+         for (std::size_t j = 0; j < configurationSettings.jetDefinitions.size(); j++)
+         {
+            std::size_t index = 0;
+            while (index < groupSettings.jetDefinitions.size() && 
+                   !IsSameJetDefinition(groupSettings.jetDefinitions[index], 
+                                        configurationSettings.jetDefinitions[j])) 
+            {
+               index++;
+            }
+            // the definition keeps the name from the first configuration in which it appears
+            if (index == groupSettings.jetDefinitions.size())
+            {
+               groupSettings.jetDefinitions.push_back(configurationSettings.jetDefinitions[j]);
+               groupSettings.jetNames.push_back(configurationSettings.jetNames[j]);
+            }
+            jetIndices[k].push_back(index);
+         }
+      }
+
+      if (isScan)
+      {
+         std::cout << "[\033[1m\033[32mINFO\033[0m] Generating configuration(s)";
+         for (const std::size_t i : group) std::cout << " " << i + 1;
+         std::cout << " of " << configurations.size() << std::endl;
+      }
+
+      std::vector<GeneratorOutput> outputs;
+      GenerateConfiguration(groupSettings, numberOfEvents, outputs);
+      const GeneratorOutput &groupOutput = outputs[0];
+
+      // printing cross section (Can you deduce what the unit of measurement for this quantity is?)
+      std::cout << groupOutput.info.sigmaGen << std::endl;
+
+      // the event store is written when the merger is deleted; cross section information
+      // is added to it since it is needed to normalize the histograms obtained from it
+      if (storeEvents)
+      {
+         delete eventsMerger;
+         TFile eventsFile(eventsFileName.c_str(), "UPDATE");
+         groupOutput.info.Write();
+         eventsFile.Close();
+      }
+
+      // histograms of the group are copied to its configurations
+      for (std::size_t k = 0; k < group.size(); k++)
+      {
+         const std::size_t i = group[k];
+         GeneratorOutput output(settings[i]);
+         output.distrHardProcessPartonsPT.Add(&groupOutput.distrHardProcessPartonsPT);
+         for (std::size_t j = 0; j < output.distrJetsPT.size(); j++)
+         {
+            output.distrJetsPT[j].Add(&groupOutput.distrJetsPT[jetIndices[k][j]]);
+         }
+         output.info = groupOutput.info;
+
+         if (isScan)
+         {
+            outputFile.mkdir(configurations[i].name.c_str(), 
+                             configurations[i].description.c_str())->cd();
+         }
+         else outputFile.cd();
+
+         // saving histograms in a TFile
+         output.Write();
+         // cross section and sum of weights are needed to normalize the histograms 
+         // and to merge them with histograms of other shards
+         output.info.Write();
+      }
+   }
+
+#ifdef COUNT_ALLOCATIONS
+   // the first number should not grow with the number of events; fastjet::ClusterSequence 
+   // allocates its own buffers for every event so the second one grows with it
+   std::cout << "[\033[1m\033[32mINFO\033[0m] Heap allocations in event loops: " << 
+                totalAllocationCount << " outside of jet reconstruction and " << 
+                totalJetAllocationCount << " in jet reconstruction (FASTJET3) for " << 
+                numberOfEvents << " events" << std::endl;
+#endif
+
+   // closing file; this is not required in the current case, however in a general case
+   // it is better to close files when you are done working with them
+   // so that there are no unintended writes/reads or assignment TObject file ownership
+   outputFile.Close();
+
+   // checkpoints are not needed after the output is written
+   for (unsigned int i = 0; i < numberOfThreads; i++)
+   {
+      std::filesystem::remove(GetCheckpointFileName(i));
+   }
+
+   return 0;
+}
+
+void GenerateConfiguration(const GeneratorSettings& settings, const long numberOfEvents, 
+                           std::vector<GeneratorOutput>& outputs)
+{
+   // there is nothing to pass to clustering threads if jets are not reconstructed
+   const unsigned int requestedClusteringThreads = numberOfClusteringThreads;
+   if (settings.partonLevel && numberOfClusteringThreads > 0)
+   {
+      std::cout << "[\033[1m\033[32mINFO\033[0m] Clustering threads are not used in parton mode" << 
+                   std::endl;
+      numberOfClusteringThreads = 0;
+   }
+
+   // with clustering threads generation and jet reconstruction run in a pipeline: generating
+   // threads pass batches of final state particles to clustering threads through a queue
+   // and take empty batches from another one; since the number of batches is limited
+   // generation waits when clustering can not keep up with it
+   std::vector<EventBatch> eventBatches;
+   if (numberOfClusteringThreads > 0)
+   {
+      eventBatches.resize(4*(numberOfThreads + numberOfClusteringThreads));
+      filledBatches = new BoundedQueue<EventBatch *>(eventBatches.size());
+      freeBatches = new BoundedQueue<EventBatch *>(eventBatches.size());
+      for (EventBatch &batch : eventBatches) freeBatches->Push(&batch);
+   }
+
+   // every thread fills its own histograms; outputs are created beforehand
+   // so that their addresses do not change when threads are started
+   outputs.clear();
+   outputs.reserve(numberOfThreads + numberOfClusteringThreads);
+   for (unsigned int i = 0; i < numberOfThreads + numberOfClusteringThreads; i++) 
+   {
+      outputs.emplace_back(settings);
+   }
+
+   std::vector<std::thread> clusteringThreads;
+   for (unsigned int i = 0; i < numberOfClusteringThreads; i++)
+   {
+      clusteringThreads.emplace_back(ClusterEvents, std::cref(settings), 
+                                     std::ref(outputs[numberOfThreads + i]));
+   }
+
+   // events are split equally between threads
+   std::vector<std::thread> threads;
+   for (unsigned int i = 1; i < numberOfThreads; i++)
+   {
+      const long nEvents = numberOfEvents/numberOfThreads +
+                           ((i < numberOfEvents % numberOfThreads) ? 1 : 0);
+      threads.emplace_back(GenerateEvents, i, std::cref(settings), nEvents, std::ref(outputs[i]));
+   }
+   // main thread also generates events
+   GenerateEvents(0, settings, numberOfEvents/numberOfThreads +
+                  ((numberOfEvents % numberOfThreads > 0) ? 1 : 0), outputs[0]);
+   for (std::thread& thread : threads) thread.join();
+
+   // clustering threads finish when all batches are processed
+   if (numberOfClusteringThreads > 0)
+   {
+      filledBatches->Close();
+      for (std::thread& thread : clusteringThreads) thread.join();
+      delete filledBatches;
+      delete freeBatches;
+   }
+
+   for (unsigned int i = 1; i < outputs.size(); i++) outputs[0].Add(outputs[i]);
+
+   numberOfClusteringThreads = requestedClusteringThreads;
+}
 
+bool HasSameGeneration(const GeneratorSettings& settings1, const GeneratorSettings& settings2)
+{
+   return settings1.pdfSet == settings2.pdfSet && settings1.pTHatMin == settings2.pTHatMin && 
+          settings1.energyCM == settings2.energyCM && 
+          settings1.pTHatBiasPower == settings2.pTHatBiasPower && 
+          settings1.pTHatBiasReference == settings2.pTHatBiasReference && 
+          settings1.partonLevel == settings2.partonLevel;
+}
+
+bool IsSameJetDefinition(const fastjet::JetDefinition& jetDefinition1, 
+                         const fastjet::JetDefinition& jetDefinition2)
+{
+   return jetDefinition1.jet_algorithm() == jetDefinition2.jet_algorithm() && 
+          jetDefinition1.R() == jetDefinition2.R() && 
+          jetDefinition1.strategy() == jetDefinition2.strategy();
+}
+
+void ConfigurePythia(Pythia8::Pythia& pythia, const GeneratorSettings& settings, const int seed)
+{
    // setting pythia collision parameters
-   // enabling hard QCD processes 
+   // enabling hard QCD processes
    // (more info on https://pythia.org/latest-manual/QCDHardProcesses.html)
-   pythia.readString("HardQCD:all = on"); 
+   pythia.readString("HardQCD:all = on");
    // by default p+p collisions will be initialized since we do not set ids of incoming particles
    // (more info on https://pythia.org/latest-manual/BeamParameters.html)
-   pythia.readString("Beams:eCM = " + std::to_string(energyCM));
+   pythia.readString("Beams:eCM = " + std::to_string(settings.energyCM));
    // setting hard process lower bound on pT [GeV/c]; processes with lower pT will not be generated
    // (more info on https://pythia.org/latest-manual/PhaseSpaceCuts.html)
-   pythia.readString("PhaseSpace:pTHatMin = " + std::to_string(pTHatMin));
+   pythia.readString("PhaseSpace:pTHatMin = " + std::to_string(settings.pTHatMin));
    // setting PDF set from LHAPDF6; pythia8 also has many predefined sets
    // (more info on https://pythia.org/latest-manual/PDFSelection.html)
-   pythia.readString("PDF:pSet = LHAPDF6:" + inputFileContents["pdfset"].as<std::string>());
+   pythia.readString("PDF:pSet = LHAPDF6:" + settings.pdfSet);
+   // events are generated with the probability multiplied by (pT-hat/reference)^power and 
+   // get weights (reference/pT-hat)^power returned by pythia.info.weight(); sigmaGen stays 
+   // the unbiased cross section so histograms are normalized by sigmaGen/weightSum as before
+   // (more info on https://pythia.org/latest-manual/PhaseSpaceCuts.html)
+   if (settings.pTHatBiasPower > 0.)
+   {
+      pythia.readString("PhaseSpace:bias2Selection = on");
+      pythia.readString("PhaseSpace:bias2SelectionPow = " + 
+                        std::to_string(settings.pTHatBiasPower));
+      pythia.readString("PhaseSpace:bias2SelectionRef = " + 
+                        std::to_string(settings.pTHatBiasReference));
+   }
+   // in parton mode pythia stops after the hard process: parton showers, multiparton interactions,
+   // beam remnants, and hadronization are not simulated
+   // (more info on https://pythia.org/latest-manual/MasterSwitches.html)
+   if (settings.partonLevel)
+   {
+      pythia.readString("PartonLevel:all = off");
+      pythia.readString("HadronLevel:all = off");
+   }
+   // every pythia object needs its own seed; otherwise all of them generate the same events
+   // (more info on https://pythia.org/latest-manual/RandomNumberSeed.html)
+   pythia.readString("Random:setSeed = on");
+   pythia.readString("Random:seed = " + std::to_string(seed));
    // uncomment the next line if you do not need for pythia to print event info and banner
    //pythia.readString("Print:quiet = on");
+}
 
-   // initializing pythia; this step pythia applies parameters we set earlier and 
-   // checks if there are problems with the current specification
-	pythia.init();
+void GenerateEvents(const unsigned int threadIndex, const GeneratorSettings& settings,
+                    const long nEvents, GeneratorOutput& output)
+{
+   // creating Pythia8:Pythia object
+   Pythia8::Pythia pythia;
+   ConfigurePythia(pythia, settings, GetPythiaSeed(shardSeed, threadIndex));
+   // only the pythia of the main thread prints event info and banner
+   if (threadIndex > 0) pythia.readString("Print:quiet = on");
 
-   // creating directory in which the file outputFile will be written
-   std::filesystem::create_directory("output");
-   // file in which all histogram will be written; the following line will create 
-   // (overwrite if exists) the file output/generated.root and root will point to it
-   // so that TObject objects can be written in it by using method TObject::Write()
-   TFile outputFile("output/generated.root", "RECREATE");
-   // if another file is created after this with option "RECREATE", "UPDATE", or "CREATE"
-   // root will try to write TObject objects to the new defined file
-   // if you have multiple TFile files you write in in yor program use 
-   // TFile::cd() to point root to the file you need
+   // initializing pythia; this step pythia applies parameters we set earlier and
+   // checks if there are problems with the current specification;
+   // initialization is serialized since LHAPDF reads and caches the pdf set files
+   {
+      std::lock_guard<std::mutex> lock(threadsMutex);
+      pythia.init();
+   }
+
+   // tree of this thread in the event store; it is owned by eventsFile
+   std::shared_ptr<ROOT::TBufferMergerFile> eventsFile;
+   TTree *eventsTree = nullptr;
+   StoredEvent storedEvent;
+   if (storeEvents)
+   {
+      eventsFile = eventsMerger->GetFile();
+      eventsFile->cd();
+      eventsTree = new TTree("events", "Generated events");
+      storedEvent.CreateBranches(eventsTree);
+   }
+
+   // batch of events passed to clustering threads if they are used
+   EventBatch *batch = nullptr;
+   if (numberOfClusteringThreads > 0) freeBatches->Pop(batch);
 
-   const int nXBins = 1000 + static_cast<int>(pTHatMin);
-   // kinematically pT can go to much higher values but for this example statistical significant result can be obtained only for this range within reasonable processing time
-   const double pTMax = 100. + pTHatMin;
-   // more info on TH1D you can find on https://root.cern.ch/doc/master/classTH1.html
-   // histogram in which pT of partons outgoing from hard processes will be written
-   TH1D distrHardProcessPartonsPT("Hard process outgoing parton pT", "N(p_{T})", nXBins, 0., pTMax);
-   // histogram in which reconstructed jets pT will be written
-   TH1D distrJetsPT("Jet pT", "N(p_{T})", nXBins, 0., pTMax);
+   // vector that will be filled with all final state particles that passed all cuts; 
+   // it is reused for all events so that its memory is allocated only a few times
+   std::vector<fastjet::PseudoJet> particles;
 
-   // you can read more about fastjet and its usage on 
-   // https://indico.cern.ch/event/264054/contributions/592237/attachments/467910/648313/fastjet-doc-3.0.3.pdf
-   fastjet::JetDefinition jetDef(fastjet::antikt_algorithm, // jet clustering algorithm
-                                 inputFileContents["fastjet_r"].as<double>()); // R parameter
+   // when the generation is resumed histograms and the random number generator state 
+   // are restored from the checkpoint and only the remaining events are generated
+   GeneratorInfo previousInfo;
+   long firstEvent = 0;
+   if (resumeFromCheckpoint && 
+       !ReadCheckpoint(threadIndex, settings, pythia, output, previousInfo, firstEvent))
+   {
+      std::lock_guard<std::mutex> lock(threadsMutex);
+      std::cout << "\033[1m\033[31mError:\033[0m checkpoint " << 
+                   GetCheckpointFileName(threadIndex) << " could not be read; "\
+                   "events of this thread are generated from the beginning" << std::endl;
+      previousInfo = GeneratorInfo();
+   }
 
-   // iterating over all events (we specified argv[2] to be the number of events we generate)
-	for (long i = 0; i < std::stoi(argv[2]); i++)
+   // pythia estimates the cross section only from its own events so its estimate is 
+   // combined with the one of the events generated before the checkpoint
+   auto getInfo = [&]() -> GeneratorInfo
    {
+      GeneratorInfo info = previousInfo;
+      GeneratorInfo currentInfo;
+      currentInfo.sigmaGen = pythia.info.sigmaGen();
+      currentInfo.sigmaErr = pythia.info.sigmaErr();
+      currentInfo.nTried = pythia.info.nTried();
+      currentInfo.nAccepted = pythia.info.nAccepted();
+      currentInfo.weightSum = output.info.weightSum;
+      info.Add(currentInfo);
+      return info;
+   };
+
+   std::chrono::steady_clock::time_point lastCheckpointTime = std::chrono::steady_clock::now();
+
+   // iterating over all events of this thread
+   for (long i = firstEvent; i < nEvents; i++)
+   {
+      // checkpoint contains all events before the current one
+      if (checkpointInterval > 0. && 
+          std::chrono::duration<double>(std::chrono::steady_clock::now() - 
+                                        lastCheckpointTime).count() > checkpointInterval)
+      {
+         WriteCheckpoint(threadIndex, settings, pythia, output, getInfo(), i, nEvents);
+         lastCheckpointTime = std::chrono::steady_clock::now();
+      }
+
       // this tells pythia to generate next event
-		if (!pythia.next()) continue;
+      if (!pythia.next()) continue;
+
+      // only allocations of this loop are counted since PYTHIA8, ROOT I/O, and FASTJET3
+      // manage their memory themselves; all vectors below are cleared without freeing
+      // their memory so the loop allocates only until the largest event is met
+      StartCountingAllocations();
+
+      particles.clear();
+      // number of particles in the event record is an upper bound on the number of final state
+      // particles; capacity is increased only when an event is larger than all previous ones
+      if (particles.capacity() < static_cast<std::size_t>(pythia.event.size()))
+      {
+         particles.reserve(2*pythia.event.size());
+      }
 
-      // vector that will be filled with all final state particles that passed all cuts
-      std::vector<fastjet::PseudoJet> particles;
-      
       // to get information on cross sections, weights, etc. use info on
       // https://pythia.org/latest-manual/CrossSectionsAndWeights.html
 
@@ -105,27 +578,76 @@ int main(int argc, char **argv)
       const double eventWeight = pythia.info.weight();
       // Exercise: Can you say if the event weight is needed in p+p and why?
 
+      if (batch) batch->AddEvent(eventWeight);
+      if (eventsTree)
+      {
+         storedEvent.Clear();
+         storedEvent.weight = eventWeight;
+      }
+
       // to get information of a pythia event you can use info on
       // https://pythia.org/latest-manual/EventRecord.html
 
+      // in parton mode there are no final state particles and jets; only the hard process record
+      // is scanned in which outgoing partons of the hard process have status 23
+      if (settings.partonLevel)
+      {
+         for (int j = 0; j < pythia.process.size(); j++)
+         {
+            if (pythia.process[j].status() != 23) continue;
+            if (!pythia.process[j].isGluon() && !pythia.process[j].isQuark()) continue;
+            output.distrHardProcessPartonsPT.Fill(pythia.process[j].pT(), eventWeight);
+
+            if (eventsTree)
+            {
+               storedEvent.AddParton(pythia.process[j].px(), pythia.process[j].py(), 
+                                     pythia.process[j].pz(), pythia.process[j].e(), 
+                                     pythia.process[j].id());
+            }
+         }
+         StopCountingAllocations();
+
+         if (eventsTree)
+         {
+            eventsTree->Fill();
+            if ((i + 1) % eventStoreFlushSize == 0) eventsFile->Write();
+         }
+         output.info.weightSum += eventWeight;
+         continue;
+      }
+
       // iterating over all particles in a current event
-		for (int j = 0; j < pythia.event.size(); j++)
+      for (int j = 0; j < pythia.event.size(); j++)
       {
-         // to get information of a particle you can use info on 
+         // to get information of a particle you can use info on
          // https://pythia.org/latest-manual/ParticleProperties.html
 
          // checking if particle is stable and did not interact with anything
-         if (pythia.event[j].isFinal()) 
+         if (pythia.event[j].isFinal())
          {
-            // prints particle id (more info on id: 
+            // prints particle id (more info on id:
             // https://pdg.lbl.gov/2007/reviews/montecarlorpp.pdf)
-            
+
             // in experiments jets usually only consist of charged (+-1q) final state particles
-            // neutral particles need to be excluded 
+            // neutral particles need to be excluded
             // (although photons and neutral hadrons can be used and sometimes are included)
             // if (abs(pythia.event[j].charge()) != 1) continue;
             // but for this work all particles will be included
 
+            if (eventsTree)
+            {
+               storedEvent.AddParticle(pythia.event[j].px(), pythia.event[j].py(), 
+                                       pythia.event[j].pz(), pythia.event[j].e());
+            }
+
+            // in the pipeline only momentum is passed to clustering threads
+            if (batch)
+            {
+               batch->AddParticle(pythia.event[j].px(), pythia.event[j].py(), 
+                                  pythia.event[j].pz(), pythia.event[j].e());
+               continue;
+            }
+
             // adding fastjet::PseudoJet entry to the particles vector
             particles.emplace_back(pythia.event[j].px(), // x component of momentum [GeV/c]
                                    pythia.event[j].py(), // y component of momentum [GeV/c]
@@ -139,39 +661,200 @@ int main(int argc, char **argv)
             if (pythia.event[j].status() != -23) continue;
             // non-partons particles (spectators, diquarks, etc.) must be removed
             if (!pythia.event[j].isGluon() && !pythia.event[j].isQuark()) continue;
-            // filling the histogram with weight eventWeight 
+            // filling the histogram with weight eventWeight
             // (i.e. adding entry with weight w = eventWeight)
             // To do : add a check that tests whether both outgoing partons are within the needed rapidity range
-            distrHardProcessPartonsPT.Fill(pythia.event[j].pT(), eventWeight);
+            output.distrHardProcessPartonsPT.Fill(pythia.event[j].pT(), eventWeight);
+
+            if (eventsTree)
+            {
+               storedEvent.AddParton(pythia.event[j].px(), pythia.event[j].py(), 
+                                     pythia.event[j].pz(), pythia.event[j].e(), 
+                                     pythia.event[j].id());
+            }
          }
       }
 
-      // running jet clustering algorithm
-      fastjet::ClusterSequence clusterSeq(particles, jetDef);
-      // vector filled with jets reconstructed from vector particles
-      std::vector<fastjet::PseudoJet> inclusiveJets = clusterSeq.inclusive_jets(pTHatMin);
+      StopCountingAllocations();
 
-      // iterating over reconstructed jets
-      for (unsigned int j = 0; j < inclusiveJets.size(); j++)
+      if (eventsTree)
       {
-         // To do : add a check that tests whether jets are within the needed rapidity range
-         distrJetsPT.Fill(inclusiveJets[j].pt(), eventWeight);
+         eventsTree->Fill();
+         // filled part of the tree is passed to the merger so that it is not kept in memory
+         if ((i + 1) % eventStoreFlushSize == 0) eventsFile->Write();
       }
+
+      output.info.weightSum += eventWeight;
+
+      // full batch is passed to clustering threads and the next empty one is taken;
+      // this waits if all batches are waiting for the clustering
+      if (batch)
+      {
+         if (batch->GetNumberOfEvents() == eventBatchSize)
+         {
+            filledBatches->Push(batch);
+            freeBatches->Pop(batch);
+         }
+         continue;
+      }
+
+      // you can read more about fastjet and its usage on
+      // https://indico.cern.ch/event/264054/contributions/592237/attachments/467910/648313/fastjet-doc-3.0.3.pdf
+      StartCountingJetAllocations();
+      FillJets(particles, settings.jetDefinitions, settings.pTHatMin, 
+               eventWeight, output);
+      StopCountingAllocations();
    }
 
-   // printing cross section (Can you deduce what the unit of measurement for this quantity is?)
-   std::cout << pythia.info.sigmaGen() << std::endl;
+   if (eventsTree) eventsFile->Write();
 
-   // saving histograms in a TFile
-   distrHardProcessPartonsPT.Write();
-   distrJetsPT.Write();
+   // the last batch may be incomplete
+   if (batch)
+   {
+      if (batch->GetNumberOfEvents() > 0) filledBatches->Push(batch);
+      else freeBatches->Push(batch);
+   }
 
-   // closing file; this is not required in the current case, however in a general case
-   // it is better to close files when you are done working with them 
-   // so that there are no unintended writes/reads or assignment TObject file ownership
-   outputFile.Close();
+   // cross section estimated by this pythia object; it is combined with other threads later
+   output.info = getInfo();
 
-   return 0;
+   AddThreadAllocationCount();
+}
+
+void ClusterEvents(const GeneratorSettings& settings, GeneratorOutput& output)
+{
+   // vector is reused for all events so that its memory is allocated only once
+   std::vector<fastjet::PseudoJet> particles;
+
+   EventBatch *batch;
+   while (filledBatches->Pop(batch))
+   {
+      for (int i = 0; i < batch->GetNumberOfEvents(); i++)
+      {
+         StartCountingAllocations();
+         particles.clear();
+         for (int j = batch->GetFirstParticle(i); j < batch->GetFirstParticle(i + 1); j++)
+         {
+            const double *momentum = batch->momenta.data() + 4*j;
+            particles.emplace_back(momentum[0], momentum[1], momentum[2], momentum[3]);
+         }
+
+         StartCountingJetAllocations();
+         FillJets(particles, settings.jetDefinitions, settings.pTHatMin, 
+                  batch->weights[i], output);
+         StopCountingAllocations();
+      }
+
+      // batch is returned to generating threads
+      batch->Clear();
+      freeBatches->Push(batch);
+   }
+
+   AddThreadAllocationCount();
+}
+
+std::string GetCheckpointFileName(const unsigned int threadIndex)
+{
+   const std::string shardSuffix = (numberOfShards > 1) ? 
+                                   "_shard" + std::to_string(shardIndex) : "";
+   return "output/checkpoint" + shardSuffix + "_thread" + std::to_string(threadIndex) + ".root";
+}
+
+std::string GetCheckpointConfiguration(const GeneratorSettings& settings)
+{
+   std::ostringstream configuration;
+   configuration.precision(std::numeric_limits<double>::max_digits10);
+   configuration << "energy=" << settings.energyCM << ";pdfset=" << settings.pdfSet << 
+                    ";pthatmin=" << settings.pTHatMin << 
+                    ";pthat_bias_power=" << settings.pTHatBiasPower << 
+                    ";pthat_bias_reference=" << settings.pTHatBiasReference << 
+                    ";mode=" << (settings.partonLevel ? "parton" : "full");
+   for (std::size_t i = 0; i < settings.jetDefinitions.size(); i++)
+   {
+      configuration << ";jets=" << settings.jetNames[i] << ":" << 
+                       settings.jetDefinitions[i].description();
+   }
+   return configuration.str();
+}
+
+void WriteCheckpoint(const unsigned int threadIndex, const GeneratorSettings& settings, 
+                     Pythia8::Pythia& pythia, const GeneratorOutput& output, 
+                     const GeneratorInfo& info, const long nEventsDone, const long nEvents)
+{
+   const std::string fileName = GetCheckpointFileName(threadIndex);
+   const std::string temporaryFileName = fileName + ".tmp";
+
+   // pythia can only dump the state of its random number generator to a file;
+   // it is copied to the checkpoint so that the checkpoint is a single file
+   const std::string rndmFileName = fileName + ".rndm";
+   pythia.rndm.dumpState(rndmFileName);
+   std::ifstream rndmFile(rndmFileName, std::ios::binary);
+   std::vector<char> rndmState((std::istreambuf_iterator<char>(rndmFile)), 
+                               std::istreambuf_iterator<char>());
+   rndmFile.close();
+   std::filesystem::remove(rndmFileName);
+
+   // configuration is checked when the run is resumed
+   const std::string configuration = GetCheckpointConfiguration(settings);
+
+   TFile checkpointFile(temporaryFileName.c_str(), "RECREATE");
+   checkpointFile.WriteObject(&configuration, "configuration");
+   output.Write();
+   info.Write();
+   TParameter<Long64_t>("nEventsDone", nEventsDone).Write();
+   TParameter<Long64_t>("nEvents", nEvents).Write();
+   TParameter<Long64_t>("baseSeed", baseSeed).Write();
+   TParameter<Long64_t>("numberOfThreads", numberOfThreads).Write();
+   checkpointFile.WriteObject(&rndmState, "rndmState");
+   checkpointFile.Close();
+
+   // renaming is atomic so the previous checkpoint is replaced only by a complete one
+   std::filesystem::rename(temporaryFileName, fileName);
+}
+
+bool ReadCheckpoint(const unsigned int threadIndex, const GeneratorSettings& settings,
+                    Pythia8::Pythia& pythia, GeneratorOutput& output, GeneratorInfo& info, 
+                    long& nEventsDone)
+{
+   const std::string fileName = GetCheckpointFileName(threadIndex);
+   if (!std::filesystem::exists(fileName)) return false;
+
+   TFile checkpointFile(fileName.c_str(), "READ");
+
+   // everything is read to temporary objects first so that a partially read checkpoint 
+   // is not added to the histograms of the run that is then started from the beginning
+   GeneratorOutput checkpointOutput(settings);
+   GeneratorInfo checkpointInfo;
+   TParameter<Long64_t> *nEventsDoneParameter;
+   std::vector<char> *rndmState;
+   checkpointFile.GetObject("nEventsDone", nEventsDoneParameter);
+   checkpointFile.GetObject("rndmState", rndmState);
+   bool isRead = nEventsDoneParameter && rndmState && 
+                 checkpointInfo.Read(&checkpointFile) && checkpointOutput.Read(&checkpointFile);
+
+   if (isRead)
+   {
+      const std::string rndmFileName = fileName + ".rndm";
+      std::ofstream rndmFile(rndmFileName, std::ios::binary);
+      rndmFile.write(rndmState->data(), static_cast<std::streamsize>(rndmState->size()));
+      rndmFile.close();
+      isRead = pythia.rndm.readState(rndmFileName);
+      std::filesystem::remove(rndmFileName);
+   }
+
+   if (isRead)
+   {
+      nEventsDone = nEventsDoneParameter->GetVal();
+      info = checkpointInfo;
+      // information of the checkpoint is kept in info so checkpointOutput.info is empty 
+      // and only the histograms are added
+      output.Add(checkpointOutput);
+   }
+
+   delete nEventsDoneParameter;
+   delete rndmState;
+   checkpointFile.Close();
+   return isRead;
 }
 
 #endif /* GENERATE_DATA_CPP */
@@ -0,0 +1,143 @@
+/**
+ *  @file   MergeData.cpp
+ *  @brief  Contains merging of the output files of several shards of GenerateData into one file
+ *
+ *  This file is a part of a project HadronProcessesLO (https://github.com/Sergeyir/HadronProcessesLO).
+ *
+ *  @author Sergei Antsupov (antsupov0124@gmail.com)
+ **/
+#ifndef MERGE_DATA_CPP
+#define MERGE_DATA_CPP
+
+#include "MergeData.hpp"
+
+int main(int argc, char **argv)
+{
+   // printing info on usage and exiting program if number of parameters is incorrect
+   if (argc < 3)
+   {
+      std::cout << "\033[1m\033[31mError:\033[0m Expected at least 2 parameters while " <<
+                   std::to_string(argc - 1) << " parameter(s) were provided \n"\
+                   "Usage: bin/MergeData outputFileName.root inputFileName1.root "\
+                   "[inputFileName2.root ...]" << std::endl;
+      return 1;
+   }
+
+   // histograms read from the input files must stay in memory after the files are closed
+   TH1::AddDirectory(false);
+
+   for (int i = 2; i < argc; i++)
+   {
+      if (!std::filesystem::exists(argv[i]))
+      {
+         std::cout << "\033[1m\033[31mError:\033[0m file " << argv[i] << " was not found" << std::endl;
+         return 1;
+      }
+
+      TFile inputFile(argv[i], "READ");
+      if (inputFile.IsZombie())
+      {
+         std::cout << "\033[1m\033[31mError:\033[0m file " << argv[i] <<
+                      " could not be read" << std::endl;
+         return 1;
+      }
+      MergeDirectory(&inputFile, "");
+      inputFile.Close();
+   }
+
+   // files without cross section information can not be normalized after merging
+   if (mergedInfos.empty())
+   {
+      std::cout << "\033[1m\033[31mError:\033[0m no cross section information was found "\
+                   "in the input files" << std::endl;
+      return 1;
+   }
+
+   TFile outputFile(argv[1], "RECREATE");
+
+   for (const std::string& path : histogramPaths)
+   {
+      const std::size_t separator = path.rfind('/');
+      GetOutputDirectory(outputFile, (separator == std::string::npos) ?
+                                     "" : path.substr(0, separator))->cd();
+      mergedHistograms[path]->Write();
+      delete mergedHistograms[path];
+   }
+   for (const std::string& path : infoPaths)
+   {
+      GetOutputDirectory(outputFile, path)->cd();
+      mergedInfos[path].Write();
+   }
+
+   // printing merged cross section
+   std::cout << mergedInfos[infoPaths.front()].sigmaGen << std::endl;
+
+   outputFile.Close();
+
+   return 0;
+}
+
+void MergeDirectory(TDirectory *directory, const std::string& path)
+{
+   // sigmaGen of independent runs are combined with weights of their numbers
+   // of tried events while the sums of weights are added
+   GeneratorInfo info;
+   if (info.Read(directory))
+   {
+      if (mergedInfos.find(path) == mergedInfos.end())
+      {
+         infoPaths.push_back(path);
+         mergedInfos[path] = info;
+      }
+      else mergedInfos[path].Add(info);
+   }
+
+   TIter nextKey(directory->GetListOfKeys());
+   while (TKey *key = static_cast<TKey *>(nextKey()))
+   {
+      const std::string name = key->GetName();
+      // objects that were overwritten have several cycles; only the last one is read
+      if (key->GetCycle() != directory->GetKey(name.c_str())->GetCycle()) continue;
+
+      const std::string objectPath = path.empty() ? name : path + "/" + name;
+
+      TObject *object = key->ReadObj();
+
+      // directories are owned by the file so they are not deleted
+      if (TDirectory *subdirectory = dynamic_cast<TDirectory *>(object))
+      {
+         MergeDirectory(subdirectory, objectPath);
+         continue;
+      }
+
+      // histograms are filled with event weights so they are simply added
+      TH1 *histogram = dynamic_cast<TH1 *>(object);
+      if (!histogram)
+      {
+         // cross section information was already read above
+         delete object;
+         continue;
+      }
+
+      auto merged = mergedHistograms.find(objectPath);
+      if (merged == mergedHistograms.end())
+      {
+         histogramPaths.push_back(objectPath);
+         mergedHistograms[objectPath] = histogram;
+      }
+      else
+      {
+         merged->second->Add(histogram);
+         delete histogram;
+      }
+   }
+}
+
+TDirectory *GetOutputDirectory(TFile& file, const std::string& path)
+{
+   if (path.empty()) return &file;
+   // existing directory is returned if it was already created
+   return file.mkdir(path.c_str(), "", true);
+}
+
+#endif /* MERGE_DATA_CPP */
@@ -0,0 +1,233 @@
+/**
+ *  @file   PDFGrid.cpp
+ *  @brief  Contains implementation of class PDFGrid that tabulates LHAPDF pdf set in memory and interpolates it with batched lookups
+ *
+ *  This file is a part of a project HadronProcessesLO (https://github.com/Sergeyir/HadronProcessesLO).
+ *
+ *  @author Sergei Antsupov (antsupov0124@gmail.com)
+ **/
+#ifndef PDF_GRID_CPP
+#define PDF_GRID_CPP
+
+#include "PDFGrid.hpp"
+
+PDFGrid::PDFGrid(const LHAPDF::PDF *pdf, const double Q2Min, const int nU, const int nLogQ2) :
+   nU(nU), nLogQ2(nLogQ2)
+{
+   // the last node is placed slightly below 1 since u diverges at x = 1;
+   // densities there are negligible and are interpolated towards 0
+   Fill(pdf->xMin(), std::min(pdf->xMax(), 1. - 1e-6), 
+        (Q2Min > 0.) ? std::min(Q2Min, pdf->q2Min()) : pdf->q2Min(), pdf->q2Max(),
+        [&](const double x, const double Q2, std::vector<double>& xfx) 
+        {pdf->xfxQ2(x, Q2, xfx);}, 
+        [&](const double Q2) {return pdf->alphasQ2(Q2);});
+}
+
+PDFGrid::PDFGrid(const int nU, const int nLogQ2) :
+   nU(nU), nLogQ2(nLogQ2)
+{
+   // valence quarks, symmetric sea, and gluon with the usual x^a (1 - x)^b shapes; 
+   // sea and gluon grow with Q^2 at small x and valence quarks fall at large x
+   auto getXFX = [](const double x, const double Q2, std::vector<double>& xfx)
+   {
+      const double evolution = log(Q2/2.);
+      const double sea = 0.15*pow(x, -0.25 - 0.01*evolution)*pow(1. - x, 7.);
+      const double valenceFactor = pow(1. - x, 0.1*evolution);
+
+      xfx.assign(nFlavours, 0.);
+      // gluon
+      xfx[6] = 1.7*pow(x, -0.3 - 0.015*evolution)*pow(1. - x, 5.);
+      // d, u, s, c, b and their antiquarks
+      const double seaFractions[5] = {1., 1., 0.5, 0.2, 0.1};
+      for (int id = 1; id <= 5; id++)
+      {
+         xfx[6 + id] = seaFractions[id - 1]*sea;
+         xfx[6 - id] = seaFractions[id - 1]*sea;
+      }
+      xfx[7] += 1.2*sqrt(x)*pow(1. - x, 4.)*valenceFactor;
+      xfx[8] += 2.2*sqrt(x)*pow(1. - x, 3.)*valenceFactor;
+   };
+   // 1-loop running with 5 flavours and \Lambda_{QCD} = 0.2 GeV
+   auto getAlphaS = [](const double Q2)
+   {
+      return 12.*M_PI/(23.*log(Q2/0.04));
+   };
+
+   Fill(1e-9, 1. - 1e-6, 2., 1e10, getXFX, getAlphaS);
+}
+
+template<typename XFXFunction, typename AlphaSFunction>
+void PDFGrid::Fill(const double xMin, const double xMax, const double Q2Min, const double Q2Max,
+                   XFXFunction getXFX, AlphaSFunction getAlphaS)
+{
+   uMin = log(xMin/(1. - xMin));
+   const double uStep = (log(xMax/(1. - xMax)) - uMin)/static_cast<double>(nU - 1);
+   uInvStep = 1./uStep;
+
+   logQ2Min = log(Q2Min);
+   const double logQ2Step = (log(Q2Max) - logQ2Min)/static_cast<double>(nLogQ2 - 1);
+   logQ2InvStep = 1./logQ2Step;
+
+   table.resize(static_cast<std::size_t>(nFlavours*nLogQ2*nU));
+   alphaSTable.resize(nLogQ2);
+
+   std::vector<double> xfx;
+   for (int j = 0; j < nLogQ2; j++)
+   {
+      // nodes are clamped to the range of the pdf set to avoid rounding errors on the edges
+      const double Q2 = std::clamp(exp(logQ2Min + logQ2Step*j), Q2Min, Q2Max);
+      alphaSTable[j] = getAlphaS(Q2);
+
+      for (int i = 0; i < nU; i++)
+      {
+         const double x = std::clamp(1./(1. + exp(-uMin - uStep*i)), xMin, xMax);
+         getXFX(x, Q2, xfx);
+         for (int f = 0; f < nFlavours; f++)
+         {
+            table[(f*nLogQ2 + j)*nU + i] = xfx[f];
+         }
+      }
+   }
+}
+
+void PDFGrid::xfx(const int flavour, const double *x, const double *Q2,
+                  double *out, const std::size_t n) const
+{
+   const double *flavourTable = table.data() +
+                                static_cast<std::size_t>(GetFlavourIndex(flavour)*nLogQ2*nU);
+
+   // the loop has no branches except for the clamping so that the compiler can vectorize it
+   for (std::size_t k = 0; k < n; k++)
+   {
+      // x >= 1 is kinematically forbidden and gives 0
+      const double xk = std::clamp(x[k], 1e-300, 1. - 1e-16);
+      const double inRange = (x[k] < 1.) ? 1. : 0.;
+
+      int iU, iQ2;
+      double wU[4], wQ2[4];
+      GetStencil((log(xk/(1. - xk)) - uMin)*uInvStep, nU, iU, wU);
+      GetStencil((log(Q2[k]) - logQ2Min)*logQ2InvStep, nLogQ2, iQ2, wQ2);
+
+      double result = 0.;
+      for (int j = 0; j < 4; j++)
+      {
+         const double *row = flavourTable + (iQ2 + j)*nU + iU;
+         result += wQ2[j]*(wU[0]*row[0] + wU[1]*row[1] + wU[2]*row[2] + wU[3]*row[3]);
+      }
+      out[k] = inRange*result;
+   }
+}
+
+void PDFGrid::xfxQ2(const double x, const double Q2, std::vector<double>& xfx) const
+{
+   xfx.resize(nFlavours);
+   if (x >= 1.)
+   {
+      std::fill(xfx.begin(), xfx.end(), 0.);
+      return;
+   }
+
+   const double xk = std::max(x, 1e-300);
+
+   int iU, iQ2;
+   double wU[4], wQ2[4];
+   GetStencil((log(xk/(1. - xk)) - uMin)*uInvStep, nU, iU, wU);
+   GetStencil((log(Q2) - logQ2Min)*logQ2InvStep, nLogQ2, iQ2, wQ2);
+
+   // weights are the same for all flavours so only the table lookups are repeated
+   for (int f = 0; f < nFlavours; f++)
+   {
+      double result = 0.;
+      for (int j = 0; j < 4; j++)
+      {
+         const double *row = table.data() + (f*nLogQ2 + iQ2 + j)*nU + iU;
+         result += wQ2[j]*(wU[0]*row[0] + wU[1]*row[1] + wU[2]*row[2] + wU[3]*row[3]);
+      }
+      xfx[f] = result;
+   }
+}
+
+void PDFGrid::alphasQ2(const double *Q2, double *out, const std::size_t n) const
+{
+   for (std::size_t k = 0; k < n; k++)
+   {
+      int iQ2;
+      double wQ2[4];
+      GetStencil((log(Q2[k]) - logQ2Min)*logQ2InvStep, nLogQ2, iQ2, wQ2);
+      out[k] = wQ2[0]*alphaSTable[iQ2] + wQ2[1]*alphaSTable[iQ2 + 1] +
+               wQ2[2]*alphaSTable[iQ2 + 2] + wQ2[3]*alphaSTable[iQ2 + 3];
+   }
+}
+
+double PDFGrid::alphasQ2(const double Q2) const
+{
+   double result;
+   alphasQ2(&Q2, &result, 1);
+   return result;
+}
+
+double PDFGrid::GetQ2Min() const
+{
+   return exp(logQ2Min);
+}
+
+double PDFGrid::GetMaxDeviation(const LHAPDF::PDF *pdf, const int nPoints,
+                                const double Q2Min, const double Q2Max) const
+{
+   // fixed seed is used so that the check gives the same result for every run
+   TRandom random(1);
+
+   const double logXMin = log(pdf->xMin());
+   const double logQ2Low = log(Q2Min);
+   const double logQ2High = log(std::min(Q2Max, pdf->q2Max()));
+
+   double maxDeviation = 0.;
+   std::vector<double> expected, interpolated;
+   for (int i = 0; i < nPoints; i++)
+   {
+      // points are distributed uniformly in ln(x) and ln(Q^2)
+      const double x = std::min(exp(random.Uniform(logXMin, 0.)), pdf->xMax());
+      const double Q2 = exp(random.Uniform(logQ2Low, logQ2High));
+
+      pdf->xfxQ2(x, Q2, expected);
+      expected.resize(nFlavours);
+      xfxQ2(x, Q2, interpolated);
+      expected.push_back(pdf->alphasQ2(Q2));
+      interpolated.push_back(alphasQ2(Q2));
+
+      for (unsigned int j = 0; j < expected.size(); j++)
+      {
+         const double deviation = fabs(interpolated[j] - expected[j])/
+                                  std::max(fabs(expected[j]), 1e-3);
+         maxDeviation = std::max(maxDeviation, deviation);
+      }
+   }
+   return maxDeviation;
+}
+
+void PDFGrid::GetStencil(const double position, const int nNodes, int &index, double *weights)
+{
+   // 4 nodes [index, index + 3] surround the position; on the edges of the table the
+   // position is clamped so that the interpolation never reads outside of the table
+   const double clampedPosition = std::clamp(position, 0., static_cast<double>(nNodes - 1));
+   index = std::clamp(static_cast<int>(clampedPosition) - 1, 0, nNodes - 4);
+
+   // cubic Lagrange polynomial through nodes placed at t = -1, 0, 1, 2; 
+   // t is outside of [0, 1] only on the first and the last intervals of the table
+   const double t = clampedPosition - static_cast<double>(index + 1);
+   const double tp1 = t + 1.;
+   const double tm1 = t - 1.;
+   const double tm2 = t - 2.;
+
+   weights[0] = -t*tm1*tm2/6.;
+   weights[1] = 0.5*tp1*tm1*tm2;
+   weights[2] = -0.5*tp1*t*tm2;
+   weights[3] = tp1*t*tm1/6.;
+}
+
+int PDFGrid::GetFlavourIndex(const int id)
+{
+   return ((id == 21) ? 0 : id) + 6;
+}
+
+#endif /* PDF_GRID_CPP */
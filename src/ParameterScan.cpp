@@ -0,0 +1,100 @@
+/**
+ *  @file   ParameterScan.cpp
+ *  @brief  Contains implementation of the reading of the grid of configurations from the "scan" node of the input file
+ *
+ *  This file is a part of a project HadronProcessesLO (https://github.com/Sergeyir/HadronProcessesLO).
+ *
+ *  @author Sergei Antsupov (antsupov0124@gmail.com)
+ **/
+#ifndef PARAMETER_SCAN_CPP
+#define PARAMETER_SCAN_CPP
+
+#include "ParameterScan.hpp"
+
+bool ReadScanConfigurations(const YAML::Node& inputFileContents,
+                            std::vector<ScanConfiguration>& configurations)
+{
+   if (!inputFileContents["scan"])
+   {
+      configurations.push_back({inputFileContents, "", ""});
+      return true;
+   }
+
+   const YAML::Node scan = inputFileContents["scan"];
+   if (!scan.IsMap() || scan.size() == 0)
+   {
+      std::cout << "\033[1m\033[31mError:\033[0m scan must be a map of parameters "\
+                   "to the lists of their values" << std::endl;
+      return false;
+   }
+
+   std::vector<std::string> keys;
+   std::vector<YAML::Node> values;
+   for (const auto& entry : scan)
+   {
+      keys.push_back(entry.first.as<std::string>());
+      values.push_back(entry.second);
+      if (!entry.second.IsSequence() || entry.second.size() == 0)
+      {
+         std::cout << "\033[1m\033[31mError:\033[0m values of scanned parameter " <<
+                      keys.back() << " must be a non-empty list" << std::endl;
+         return false;
+      }
+      if (keys.back() == "scan")
+      {
+         std::cout << "\033[1m\033[31mError:\033[0m scan can not be scanned" << std::endl;
+         return false;
+      }
+   }
+
+   // every configuration is given by the index of the value of every parameter;
+   // indices are incremented as digits of a number with the last parameter as the lowest digit
+   std::vector<std::size_t> indices(keys.size(), 0);
+   while (true)
+   {
+      ScanConfiguration configuration;
+      // the copy is deep so that the configurations do not share the nodes that are replaced
+      configuration.inputFileContents = YAML::Clone(inputFileContents);
+      configuration.inputFileContents.remove("scan");
+
+      for (std::size_t i = 0; i < keys.size(); i++)
+      {
+         const YAML::Node value = values[i][indices[i]];
+         configuration.inputFileContents[keys[i]] = YAML::Clone(value);
+
+         // lists and maps (e.g. lists of jets) are named by their index in the list of values
+         const std::string valueName = value.IsScalar() ?
+                                       value.Scalar() : "#" + std::to_string(indices[i]);
+
+         if (i > 0)
+         {
+            configuration.name += "_";
+            configuration.description += " ";
+         }
+         configuration.name += keys[i] + "_" + valueName;
+         configuration.description += keys[i] + "=" + valueName;
+      }
+
+      // "/" would be read by ROOT as a subdirectory and ";" as a cycle of an object
+      for (char &c : configuration.name)
+      {
+         if (!std::isalnum(static_cast<unsigned char>(c)) && c != '.' && c != '-' && c != '_')
+         {
+            c = '_';
+         }
+      }
+      configurations.push_back(configuration);
+
+      int i = static_cast<int>(keys.size()) - 1;
+      for (; i >= 0; i--)
+      {
+         if (++indices[i] < values[i].size()) break;
+         indices[i] = 0;
+      }
+      if (i < 0) break;
+   }
+
+   return true;
+}
+
+#endif /* PARAMETER_SCAN_CPP */
@@ -0,0 +1,49 @@
+/**
+ *  @file   RandomSeed.cpp
+ *  @brief  Contains implementation of functions that provide seeds of random number generators for all executables
+ *
+ *  This file is a part of a project HadronProcessesLO (https://github.com/Sergeyir/HadronProcessesLO).
+ *
+ *  @author Sergei Antsupov (antsupov0124@gmail.com)
+ **/
+#ifndef RANDOM_SEED_CPP
+#define RANDOM_SEED_CPP
+
+#include "RandomSeed.hpp"
+
+unsigned int GetRandomSeed()
+{
+	auto now = std::chrono::high_resolution_clock::now();
+	auto now_ms = std::chrono::time_point_cast<std::chrono::milliseconds>(now);
+	auto epoch = now_ms.time_since_epoch();
+	auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(epoch);
+	return static_cast<unsigned int>(duration.count() % 900000000);
+}
+
+uint64_t GetSplitMix64Hash(uint64_t value)
+{
+   value = (value ^ (value >> 30))*0xbf58476d1ce4e5b9ULL;
+   value = (value ^ (value >> 27))*0x94d049bb133111ebULL;
+   return value ^ (value >> 31);
+}
+
+unsigned int GetBinSeed(const unsigned int seed, const int bin, const int batch)
+{
+   // hash of the combination of the base seed, the bin index, and the batch index 
+   // (the first batch gets the same seed as the bin itself)
+   const uint64_t z = GetSplitMix64Hash((static_cast<uint64_t>(seed) << 32) + 
+                                        static_cast<uint64_t>(bin) + 
+                                        static_cast<uint64_t>(batch)*0x9e3779b97f4a7c15ULL);
+   const unsigned int result = static_cast<unsigned int>(z);
+   return (result == 0) ? 1 : result;
+}
+
+int GetPythiaSeed(const unsigned int seed, const int stream)
+{
+   // hash of the combination of the base seed and the stream index
+   const uint64_t z = GetSplitMix64Hash((static_cast<uint64_t>(seed) << 32) + 
+                                        static_cast<uint64_t>(stream));
+   return static_cast<int>(z % 900000000ULL) + 1;
+}
+
+#endif /* RANDOM_SEED_CPP */
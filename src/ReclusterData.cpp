@@ -0,0 +1,117 @@
+/**
+ *  @file   ReclusterData.cpp
+ *  @brief  Contains reconstruction of jets from events stored by GenerateData without generating them again
+ *
+ *  This file is a part of a project HadronProcessesLO (https://github.com/Sergeyir/HadronProcessesLO).
+ *
+ *  @author Sergei Antsupov (antsupov0124@gmail.com)
+ **/
+#ifndef RECLUSTER_DATA_CPP
+#define RECLUSTER_DATA_CPP
+
+#include "ReclusterData.hpp"
+
+int main(int argc, char **argv)
+{
+   // printing info on usage and exiting program if number of parameters is incorrect
+   if (argc < 3)
+   {
+      std::cout << "\033[1m\033[31mError:\033[0m Expected at least 2 parameters while " <<
+                   std::to_string(argc - 1) << " parameter(s) were provided \n"\
+                   "Usage: bin/ReclusterData inputFileName.yaml eventsFileName1.root "\
+                   "[eventsFileName2.root ...]" << std::endl;
+      std::cout << "[\033[1m\033[32mINFO\033[0m] " <<
+                   " events files are written by bin/GenerateData with option --store-events" << 
+                   std::endl;
+      return 1;
+   }
+
+   for (int i = 1; i < argc; i++)
+   {
+      if (!std::filesystem::exists(argv[i]))
+      {
+         std::cout << "\033[1m\033[31mError:\033[0m file " << argv[i] << " was not found" << std::endl;
+         return 1;
+      }
+   }
+
+   // jet definition and cuts are taken from the input file so that events generated 
+   // once can be analyzed with different parameters
+   GeneratorSettings settings;
+   if (!ReadGeneratorSettings(YAML::LoadFile(argv[1]), settings)) return 1;
+
+   // histograms must stay in memory after the events files are closed
+   TH1::AddDirectory(false);
+
+   GeneratorOutput output(settings);
+
+   // vector is reused for all events so that its memory is allocated only once
+   std::vector<fastjet::PseudoJet> particles;
+   StoredEvent event;
+
+   for (int i = 2; i < argc; i++)
+   {
+      TFile eventsFile(argv[i], "READ");
+
+      // cross sections of all files are combined in the same way as for bin/MergeData
+      GeneratorInfo info;
+      TTree *eventsTree;
+      eventsFile.GetObject("events", eventsTree);
+      if (!eventsTree || !info.Read(&eventsFile))
+      {
+         std::cout << "\033[1m\033[31mError:\033[0m file " << argv[i] << 
+                      " is not an events file" << std::endl;
+         return 1;
+      }
+      output.info.Add(info);
+
+      // only the branches of the entry are read (streamed) from the file 
+      event.SetBranchAddresses(eventsTree);
+
+      const long nEvents = eventsTree->GetEntries();
+      for (long j = 0; j < nEvents; j++)
+      {
+         eventsTree->GetEntry(j);
+
+         for (unsigned int k = 0; k < event.partonId.size(); k++)
+         {
+            output.distrHardProcessPartonsPT.Fill(sqrt(event.partonPx[k]*event.partonPx[k] + 
+                                                       event.partonPy[k]*event.partonPy[k]), 
+                                                  event.weight);
+         }
+
+         particles.clear();
+         for (unsigned int k = 0; k < event.px.size(); k++)
+         {
+            particles.emplace_back(event.px[k], event.py[k], event.pz[k], event.e[k]);
+         }
+         FillJets(particles, settings.jetDefinitions, settings.pTHatMin, 
+                  event.weight, output);
+
+         // the line below prints progress in percents
+         if ((j + 1) % 10000 == 0 || j + 1 == nEvents)
+         {
+            std::cout << argv[i] << ": " << static_cast<double>(j + 1)/
+                         static_cast<double>(nEvents)*100. << "%\r" << std::flush;
+         }
+      }
+      std::cout << std::endl;
+
+      eventsFile.Close();
+   }
+
+   // printing cross section
+   std::cout << output.info.sigmaGen << std::endl;
+
+   std::filesystem::create_directory("output");
+   TFile outputFile("output/reclustered.root", "RECREATE");
+
+   output.Write();
+   output.info.Write();
+
+   outputFile.Close();
+
+   return 0;
+}
+
+#endif /* RECLUSTER_DATA_CPP */
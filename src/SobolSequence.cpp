@@ -0,0 +1,113 @@
+/**
+ *  @file   SobolSequence.cpp
+ *  @brief  Contains implementation of class SobolSequence that generates scrambled Sobol low discrepancy points for quasi-Monte Carlo integration
+ *
+ *  This file is a part of a project HadronProcessesLO (https://github.com/Sergeyir/HadronProcessesLO).
+ *
+ *  @author Sergei Antsupov (antsupov0124@gmail.com)
+ **/
+#ifndef SOBOL_SEQUENCE_CPP
+#define SOBOL_SEQUENCE_CPP
+
+#include "SobolSequence.hpp"
+
+namespace
+{
+   /// degree s of primitive polynomials for dimensions starting from the 2nd
+   constexpr int polynomialDegree[SobolSequence::maxDimension - 1] = {1, 2, 3, 3, 4, 4, 5, 5, 5};
+   /// coefficients a of primitive polynomials for dimensions starting from the 2nd
+   constexpr uint32_t polynomialCoefficients[SobolSequence::maxDimension - 1] =
+      {0, 1, 1, 2, 1, 4, 2, 4, 7};
+   /// initial direction numbers m_i for dimensions starting from the 2nd
+   constexpr uint32_t initialDirections[SobolSequence::maxDimension - 1][5] =
+      {{1}, {1, 3}, {1, 3, 1}, {1, 1, 1}, {1, 1, 3, 3},
+       {1, 3, 5, 13}, {1, 1, 5, 5, 17}, {1, 1, 5, 5, 5}, {1, 1, 7, 11, 19}};
+
+   /* @brief splitmix64 generator used to obtain scrambling bits
+    *
+    * @param[in] state state of the generator that is advanced
+    * @param[out] random 64 bit number
+    */
+   uint64_t SplitMix64(uint64_t &state)
+   {
+      uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+      z = (z ^ (z >> 30))*0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27))*0x94d049bb133111ebULL;
+      return z ^ (z >> 31);
+   }
+}
+
+SobolSequence::SobolSequence(const int dimension, const uint64_t scrambleSeed) :
+   dimension(dimension), directions(dimension*nBits), current(dimension)
+{
+   if (dimension < 1 || dimension > maxDimension)
+   {
+      throw std::invalid_argument("SobolSequence supports from 1 to " +
+                                  std::to_string(maxDimension) + " dimensions");
+   }
+
+   // direction number k is stored with its most significant bit at position nBits - 1 - k
+   std::vector<uint32_t> v(nBits);
+   uint64_t state = scrambleSeed;
+
+   for (int d = 0; d < dimension; d++)
+   {
+      if (d == 0)
+      {
+         // the first dimension is the van der Corput sequence
+         for (int k = 0; k < nBits; k++) v[k] = 1u << (nBits - 1 - k);
+      }
+      else
+      {
+         const int s = polynomialDegree[d - 1];
+         const uint32_t a = polynomialCoefficients[d - 1];
+         for (int k = 0; k < s; k++) v[k] = initialDirections[d - 1][k] << (nBits - 1 - k);
+         for (int k = s; k < nBits; k++)
+         {
+            v[k] = v[k - s] ^ (v[k - s] >> s);
+            for (int j = 1; j < s; j++)
+            {
+               if ((a >> (s - 1 - j)) & 1u) v[k] ^= v[k - j];
+            }
+         }
+      }
+
+      // random lower triangular matrix with unit diagonal: output digit i (counted from the
+      // most significant one) is a sum modulo 2 of input digit i and random more significant ones
+      uint32_t rows[nBits];
+      for (int i = 0; i < nBits; i++)
+      {
+         const uint32_t diagonal = 1u << (nBits - 1 - i);
+         const uint32_t moreSignificant = ~((diagonal << 1) - 1u);
+         rows[i] = diagonal | (static_cast<uint32_t>(SplitMix64(state)) & moreSignificant);
+      }
+      for (int k = 0; k < nBits; k++)
+      {
+         uint32_t scrambled = 0;
+         for (int i = 0; i < nBits; i++)
+         {
+            if (__builtin_parity(rows[i] & v[k])) scrambled |= 1u << (nBits - 1 - i);
+         }
+         directions[d*nBits + k] = scrambled;
+      }
+
+      // random digital shift is the starting point of the sequence
+      current[d] = static_cast<uint32_t>(SplitMix64(state));
+   }
+}
+
+void SobolSequence::Next(double *point)
+{
+   // the first point is the digital shift itself; every next point differs from the previous
+   // one by the direction number of the lowest zero bit of the index (Gray code order)
+   if (index > 0)
+   {
+      const int bit = __builtin_ctz(index);
+      for (int d = 0; d < dimension; d++) current[d] ^= directions[d*nBits + bit];
+   }
+   index++;
+
+   for (int d = 0; d < dimension; d++) point[d] = static_cast<double>(current[d])*0x1p-32;
+}
+
+#endif /* SOBOL_SEQUENCE_CPP */
@@ -0,0 +1,109 @@
+/**
+ *  @file   VegasGrid.cpp
+ *  @brief  Contains implementation of class VegasGrid that is used for VEGAS adaptive importance sampling in MC integration
+ *
+ *  This file is a part of a project HadronProcessesLO (https://github.com/Sergeyir/HadronProcessesLO).
+ *
+ *  @author Sergei Antsupov (antsupov0124@gmail.com)
+ **/
+#ifndef VEGAS_GRID_CPP
+#define VEGAS_GRID_CPP
+
+#include "VegasGrid.hpp"
+
+VegasGrid::VegasGrid(const int dimension, const int nBins) :
+   dimension(dimension), nBins(nBins),
+   edges(dimension*(nBins + 1)), accumulated(dimension*nBins, 0.)
+{
+   for (int d = 0; d < dimension; d++)
+   {
+      for (int i = 0; i <= nBins; i++)
+      {
+         edges[d*(nBins + 1) + i] = static_cast<double>(i)/static_cast<double>(nBins);
+      }
+   }
+}
+
+double VegasGrid::Map(const double *u, double *x, int *bins) const
+{
+   double jacobian = 1.;
+   for (int d = 0; d < dimension; d++)
+   {
+      // every bin is chosen with equal probability 1/nBins and
+      // the point is distributed uniformly inside of it
+      const double position = u[d]*static_cast<double>(nBins);
+      const int bin = std::min(static_cast<int>(position), nBins - 1);
+      const double *edge = edges.data() + d*(nBins + 1) + bin;
+      const double width = edge[1] - edge[0];
+
+      x[d] = edge[0] + (position - static_cast<double>(bin))*width;
+      bins[d] = bin;
+      jacobian *= width*static_cast<double>(nBins);
+   }
+   return jacobian;
+}
+
+void VegasGrid::Accumulate(const int *bins, const double value)
+{
+   for (int d = 0; d < dimension; d++) accumulated[d*nBins + bins[d]] += value;
+}
+
+void VegasGrid::Refine(const double alpha)
+{
+   std::vector<double> smoothed(nBins), importance(nBins), newEdges(nBins + 1);
+
+   for (int d = 0; d < dimension; d++)
+   {
+      const double *binValues = accumulated.data() + d*nBins;
+      double *edge = edges.data() + d*(nBins + 1);
+
+      // smoothing with neighbouring bins suppresses fluctuations of the grid
+      double sum = 0.;
+      for (int i = 0; i < nBins; i++)
+      {
+         const int first = std::max(i - 1, 0);
+         const int last = std::min(i + 1, nBins - 1);
+         smoothed[i] = 0.;
+         for (int j = first; j <= last; j++) smoothed[i] += binValues[j];
+         smoothed[i] /= static_cast<double>(last - first + 1);
+         sum += smoothed[i];
+      }
+      // the integrand was 0 everywhere so there is no information to adapt to
+      if (sum <= 0.) continue;
+
+      // damped importance of every bin
+      double sumOfImportance = 0.;
+      for (int i = 0; i < nBins; i++)
+      {
+         const double fraction = smoothed[i]/sum;
+         importance[i] = (fraction > 0. && fraction < 1.) ?
+                         pow((fraction - 1.)/log(fraction), alpha) : 0.;
+         sumOfImportance += importance[i];
+      }
+      if (sumOfImportance <= 0.) continue;
+
+      // new edges are placed so that every new bin contains equal share of importance
+      const double importancePerBin = sumOfImportance/static_cast<double>(nBins);
+      double accumulatedImportance = 0.;
+      int oldBin = 0;
+
+      newEdges[0] = 0.;
+      newEdges[nBins] = 1.;
+      for (int i = 1; i < nBins; i++)
+      {
+         const double target = importancePerBin*static_cast<double>(i);
+         while (oldBin < nBins - 1 && accumulatedImportance + importance[oldBin] < target)
+         {
+            accumulatedImportance += importance[oldBin];
+            oldBin++;
+         }
+         const double fraction = (importance[oldBin] > 0.) ?
+                                 (target - accumulatedImportance)/importance[oldBin] : 0.;
+         newEdges[i] = edge[oldBin] + std::clamp(fraction, 0., 1.)*(edge[oldBin + 1] - edge[oldBin]);
+      }
+      std::copy(newEdges.begin(), newEdges.end(), edge);
+   }
+   std::fill(accumulated.begin(), accumulated.end(), 0.);
+}
+
+#endif /* VEGAS_GRID_CPP */